@@ -37,6 +37,7 @@ typedef struct {
     uint32_t seq_id;                        // ID sequenziale per i messaggi
     uint8_t last_request_type;              // Ultimo tipo di richiesta inviata
     int last_move_pos;                      // Ultima posizione mossa inviata (1-9)
+    uint64_t connect_started_us;            // Avvio connessione con registrazione anticipata (0 = nessuna)
 } client_state_t;
 
 // Stato globale del client (dichiarato extern, definito in client.c)
@@ -50,13 +51,22 @@ extern client_state_t client_state;
  * Connette il client al server
  * 
  * Crea un socket TCP, si connette all'indirizzo specificato e
- * inizializza lo stato del client a CLIENT_CONNECTED.
- * 
- * @param host Indirizzo IP o hostname del server
- * @param port Porta del server
+ * inizializza lo stato del client a CLIENT_CONNECTED. Se host è un
+ * percorso (inizia con '/' o '.') o un nome astratto (inizia con '@')
+ * la connessione usa un socket AF_UNIX e la porta viene ignorata.
+ * 
+ * Se username è indicato, MSG_REGISTER viene inviato insieme alla
+ * connessione: con fast_open attivo va nel SYN tramite MSG_FASTOPEN
+ * (un RTT in meno per un giocatore che ritorna), altrimenti subito dopo
+ * l'handshake. La risposta arriva al thread di notifiche come per
+ * send_register_request().
+ * 
+ * @param host Indirizzo IP del server o percorso del socket unix
+ * @param port Porta del server (solo TCP)
+ * @param username Nome da registrare alla connessione (NULL o "" = nessuno)
  * @return 0 se successo, -1 se errore
  */
-int client_connect(const char *host, int port);
+int client_connect(const char *host, int port, const char *username);
 
 /**
  * Disconnette il client dal server
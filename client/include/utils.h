@@ -12,6 +12,9 @@ typedef struct {
     // Configurazioni di rete
     char server_ip[16];
     int port;
+    char unix_socket[108];  // Se impostato si usa AF_UNIX invece di server_ip:port ('@' = namespace astratto)
+    int fast_open;          // 1 = MSG_REGISTER nel SYN con TCP Fast Open
+    char username[32];      // Nome registrato alla connessione (vuoto = comando register)
     
     // Timeout //NOTE: Non usati al momento
     int connection_timeout;
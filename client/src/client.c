@@ -7,7 +7,10 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <stddef.h>
+#include <sys/un.h>
 #include <errno.h>
+#include <time.h>
 
 // Stato globale del client
 client_state_t client_state = {
@@ -21,52 +24,202 @@ client_state_t client_state = {
     .running = false,
     .seq_id = 0,
     .last_request_type = 0,
-    .last_move_pos = 0
+    .last_move_pos = 0,
+    .connect_started_us = 0
 };
 
 // ============================================================================
 // FUNZIONI DI CONNESSIONE
 // ============================================================================
 
-int client_connect(const char *host, int port) {
-    if (client_state.socket_fd >= 0) {
-        LOG_WARN("Client già connesso");
+/**
+ * Connette un socket AF_UNIX al server locale
+ * 
+ * @param path Percorso del socket ('@' iniziale = namespace astratto)
+ * @return File descriptor connesso, o -1 se errore
+ */
+static int connect_unix(const char *path) {
+    struct sockaddr_un server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sun_family = AF_UNIX;
+    
+    size_t path_len = strlen(path);
+    if (path_len >= sizeof(server_addr.sun_path)) {
+        LOG_ERROR("Percorso del socket unix troppo lungo: %s", path);
+        return -1;
+    }
+    memcpy(server_addr.sun_path, path, path_len);
+    if (path[0] == '@') {
+        server_addr.sun_path[0] = '\0';
+    }
+    
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0) {
+        LOG_ERROR("Errore creazione socket unix: %s", strerror(errno));
+        return -1;
+    }
+    
+    socklen_t addrlen = offsetof(struct sockaddr_un, sun_path) + path_len;
+    if (connect(sock, (struct sockaddr *)&server_addr, addrlen) < 0) {
+        LOG_ERROR("Errore connessione al socket unix %s: %s", path, strerror(errno));
+        close(sock);
         return -1;
     }
     
-    // Crea socket
+    return sock;
+}
+
+/**
+ * Connette un socket TCP al server
+ * 
+ * Con fast_open attivo e un messaggio da inviare, connessione e primo
+ * messaggio partono insieme con MSG_FASTOPEN: se il client ha già un
+ * cookie TFO del server i dati viaggiano nel SYN e risparmiano un RTT,
+ * altrimenti il kernel li invia subito dopo l'handshake.
+ * 
+ * @param server_addr Indirizzo del server
+ * @param first Messaggio già serializzato da inviare (NULL se nessuno)
+ * @param first_len Lunghezza del messaggio
+ * @param first_sent Impostato a true se il messaggio è stato inviato
+ * @return File descriptor connesso, o -1 se errore
+ */
+static int connect_tcp(const struct sockaddr_in *server_addr, const uint8_t *first,
+                       size_t first_len, bool *first_sent) {
+    *first_sent = false;
+    
     int sock = socket(AF_INET, SOCK_STREAM, 0);
     if (sock < 0) {
         LOG_ERROR("Errore creazione socket: %s", strerror(errno));
         return -1;
     }
     
-    // Prepara indirizzo server
-    struct sockaddr_in server_addr;
-    memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(port);
+    if (first && client_config.fast_open) {
+        ssize_t sent = sendto(sock, first, first_len, MSG_FASTOPEN | MSG_NOSIGNAL,
+                              (const struct sockaddr *)server_addr, sizeof(*server_addr));
+        if (sent >= 0) {
+            // Il resto (caso raro) segue come un normale invio
+            while ((size_t)sent < first_len) {
+                ssize_t more = send(sock, first + sent, first_len - sent, MSG_NOSIGNAL);
+                if (more < 0 && errno == EINTR) continue;
+                if (more <= 0) {
+                    LOG_ERROR("Errore invio del primo messaggio: %s", strerror(errno));
+                    close(sock);
+                    return -1;
+                }
+                sent += more;
+            }
+            *first_sent = true;
+            return sock;
+        }
+        if (errno != EOPNOTSUPP) {
+            LOG_ERROR("Errore connessione TCP Fast Open: %s", strerror(errno));
+            close(sock);
+            return -1;
+        }
+        LOG_WARN("TCP Fast Open non supportato dal kernel, connessione normale");
+    }
     
-    if (inet_pton(AF_INET, host, &server_addr.sin_addr) <= 0) {
-        LOG_ERROR("Indirizzo IP non valido: %s", host);
+    if (connect(sock, (const struct sockaddr *)server_addr, sizeof(*server_addr)) < 0) {
+        LOG_ERROR("Errore connessione al server: %s", strerror(errno));
         close(sock);
         return -1;
     }
+    return sock;
+}
+
+/**
+ * Prepara lo stato del client per una richiesta di registrazione
+ * 
+ * @param username Nome utente da registrare
+ * @param payload Payload da riempire
+ * @return Sequence ID da usare per il messaggio
+ */
+static uint32_t prepare_register(const char *username, payload_register_t *payload) {
+    memset(payload, 0, sizeof(*payload));
+    strncpy(payload->player_name, username, MAX_PLAYER_NAME - 1);
     
-    // Connetti al server
-    if (connect(sock, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
-        LOG_ERROR("Errore connessione al server %s:%d: %s", 
-                 host, port, strerror(errno));
-        close(sock);
+    pthread_mutex_lock(&client_state.mutex);
+    // Salva l'username nello stato del client
+    strncpy(client_state.username, username, MAX_PLAYER_NAME - 1);
+    client_state.username[MAX_PLAYER_NAME - 1] = '\0';
+    client_state.last_request_type = MSG_REGISTER;
+    client_state.connect_started_us = 0; // Misura solo la registrazione alla connessione
+    uint32_t seq = client_state.seq_id++;
+    pthread_mutex_unlock(&client_state.mutex);
+    
+    return seq;
+}
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+int client_connect(const char *host, int port, const char *username) {
+    if (client_state.socket_fd >= 0) {
+        LOG_WARN("Client già connesso");
+        return -1;
+    }
+    
+    // Registrazione anticipata: il messaggio viene serializzato prima della connessione
+    bool early_register = (username != NULL && username[0] != '\0');
+    uint8_t frame[sizeof(protocol_header_t) + sizeof(payload_register_t)];
+    uint32_t seq = 0;
+    if (early_register) {
+        payload_register_t payload;
+        seq = prepare_register(username, &payload);
+        protocol_header_t header;
+        protocol_init_header(&header, MSG_REGISTER, sizeof(payload), seq);
+        memcpy(frame, &header, sizeof(header));
+        memcpy(frame + sizeof(header), &payload, sizeof(payload));
+    }
+    
+    uint64_t started_us = now_us();
+    bool register_sent = false;
+    int sock;
+    
+    if (host[0] == '/' || host[0] == '.' || host[0] == '@') {
+        // Server sulla stessa macchina: niente stack TCP
+        sock = connect_unix(host);
+    } else {
+        struct sockaddr_in server_addr;
+        memset(&server_addr, 0, sizeof(server_addr));
+        server_addr.sin_family = AF_INET;
+        server_addr.sin_port = htons(port);
+        
+        if (inet_pton(AF_INET, host, &server_addr.sin_addr) <= 0) {
+            LOG_ERROR("Indirizzo IP non valido: %s", host);
+            return -1;
+        }
+        
+        sock = connect_tcp(&server_addr, early_register ? frame : NULL, sizeof(frame),
+                           &register_sent);
+    }
+    if (sock < 0) {
+        LOG_ERROR("Errore connessione al server %s:%d", host, port);
         return -1;
     }
     
     pthread_mutex_lock(&client_state.mutex);
     client_state.socket_fd = sock;
     client_state.state = CLIENT_CONNECTED;
+    client_state.connect_started_us = early_register ? started_us : 0;
     pthread_mutex_unlock(&client_state.mutex);
     
     LOG_INFO("Connesso al server %s:%d (fd=%d)", host, port, sock);
+    
+    if (early_register && !register_sent) {
+        if (protocol_send(sock, MSG_REGISTER, frame + sizeof(protocol_header_t),
+                          sizeof(payload_register_t), seq) < 0) {
+            LOG_ERROR("Errore invio MSG_REGISTER");
+            return -1;
+        }
+    }
+    if (early_register) {
+        LOG_DEBUG("Inviato MSG_REGISTER alla connessione: username='%s' seq=%u%s",
+                  username, seq, register_sent ? " (TCP Fast Open)" : "");
+    }
     return 0;
 }
 
@@ -117,16 +270,7 @@ int send_register_request(const char *username) {
     }
     
     payload_register_t payload;
-    memset(&payload, 0, sizeof(payload));
-    strncpy(payload.player_name, username, MAX_PLAYER_NAME - 1);
-    
-    pthread_mutex_lock(&client_state.mutex);
-    // Salva l'username nello stato del client
-    strncpy(client_state.username, username, MAX_PLAYER_NAME - 1);
-    client_state.username[MAX_PLAYER_NAME - 1] = '\0';
-    client_state.last_request_type = MSG_REGISTER;
-    uint32_t seq = client_state.seq_id++;
-    pthread_mutex_unlock(&client_state.mutex);
+    uint32_t seq = prepare_register(username, &payload);
     
     int ret = protocol_send(client_state.socket_fd, MSG_REGISTER, 
                            &payload, sizeof(payload), seq);
@@ -321,36 +465,39 @@ void *notification_thread_func(void *arg) {
     
     LOG_INFO("Thread notifiche avviato");
     
+    // Il client ha una sola connessione: un decoder statico evita
+    // un'allocazione per ogni messaggio ricevuto
+    static protocol_decoder_t decoder;
+    protocol_decoder_init(&decoder);
+    
     while (client_state.running) {
         protocol_header_t header;
+        const void *payload;
         
-        // Ricevi header
-        ssize_t ret = protocol_recv_header(client_state.socket_fd, &header);
-        if (ret < 0) {
-            if (client_state.running) {
-                LOG_ERROR("Errore ricezione header, chiudo connessione");
-                pthread_mutex_lock(&client_state.mutex);
-                client_state.running = false;
-                pthread_mutex_unlock(&client_state.mutex);
-            }
+        // Estrai il prossimo messaggio completo, leggendo dal socket se serve
+        int next = protocol_decoder_next(&decoder, &header, &payload);
+        if (next < 0) {
+            LOG_ERROR("Payload troppo grande (%u bytes), chiudo connessione", header.length);
+            pthread_mutex_lock(&client_state.mutex);
+            client_state.running = false;
+            pthread_mutex_unlock(&client_state.mutex);
             break;
         }
-        
-        // Leggi payload se presente
-        void *payload = NULL;
-        if (header.length > 0) {
-            payload = malloc(header.length);
-            if (!payload) {
-                LOG_ERROR("Errore allocazione memoria per payload");
-                break;
+        if (next == 0) {
+            ssize_t ret = protocol_decoder_fill(&decoder, client_state.socket_fd, 0);
+            if (ret < 0 && errno == EINTR) {
+                continue;
             }
-            
-            ret = protocol_recv_payload(client_state.socket_fd, payload, header.length);
-            if (ret < 0) {
-                LOG_ERROR("Errore ricezione payload");
-                free(payload);
+            if (ret <= 0) {
+                if (client_state.running) {
+                    LOG_ERROR("Errore ricezione dal server, chiudo connessione");
+                    pthread_mutex_lock(&client_state.mutex);
+                    client_state.running = false;
+                    pthread_mutex_unlock(&client_state.mutex);
+                }
                 break;
             }
+            continue;
         }
         
         // Gestisci il messaggio in base al tipo
@@ -370,14 +517,21 @@ void *notification_thread_func(void *arg) {
                     pthread_mutex_unlock(&client_state.mutex);
                     
                     switch (last_req) {
-                        case MSG_REGISTER:
+                        case MSG_REGISTER: {
                             pthread_mutex_lock(&client_state.mutex);
                             client_state.state = CLIENT_REGISTERED;
+                            uint64_t started_us = client_state.connect_started_us;
+                            client_state.connect_started_us = 0;
                             pthread_mutex_unlock(&client_state.mutex);
+                            if (started_us) {
+                                LOG_INFO("Registrazione completata %llu us dopo l'avvio della connessione",
+                                         (unsigned long long)(now_us() - started_us));
+                            }
                             printf("\n✅ Registrazione completata con successo!"
                                    "\n   Ora puoi creare una partita con 'create' o vedere le partite con 'list'.");
                             fflush(stdout);
                             break;
+                        }
                             
                         case MSG_CREATE_GAME: {
                             response_create_game_t *create_resp = (response_create_game_t *)payload;
@@ -606,10 +760,6 @@ void *notification_thread_func(void *arg) {
             printf("\n\n> ");
             fflush(stdout);
         }
-        
-        if (payload) {
-            free(payload);
-        }
     }
     
     LOG_INFO("Thread notifiche terminato");
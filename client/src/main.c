@@ -14,11 +14,23 @@ int main() {
     init_client_logging();
     LOG_INFO("Client avviato, caricamento configurazione completato");
     
-    // Connetti al server
-    printf("\nConnessione al server %s:%d...\n", 
-           client_config.server_ip, client_config.port);
+    // Connetti al server (socket unix se configurato, altrimenti TCP)
+    const char *endpoint = client_config.unix_socket[0] ? client_config.unix_socket
+                                                        : client_config.server_ip;
+    printf("\nConnessione al server %s:%d...\n", endpoint, client_config.port);
+    
+    // Giocatore che ritorna: registrazione insieme alla connessione
+    const char *username = NULL;
+    if (client_config.username[0] != '\0') {
+        if (protocol_validate_name(client_config.username)) {
+            username = client_config.username;
+        } else {
+            printf("Username '%s' non valido nella configurazione, usa 'register'\n",
+                   client_config.username);
+        }
+    }
     
-    if (client_connect(client_config.server_ip, client_config.port) < 0) {
+    if (client_connect(endpoint, client_config.port, username) < 0) {
         fprintf(stderr, "Errore: impossibile connettersi al server\n");
         return EXIT_FAILURE;
     }
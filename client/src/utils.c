@@ -42,6 +42,12 @@ int load_config(const char* config_file, ClientConfig* config) {
             strncpy(config->server_ip, value, sizeof(config->server_ip) - 1);
         } else if (strcmp(key, "server_port") == 0) {
             config->port = atoi(value);
+        } else if (strcmp(key, "unix_socket") == 0) {
+            strncpy(config->unix_socket, value, sizeof(config->unix_socket) - 1);
+        } else if (strcmp(key, "fast_open") == 0) {
+            config->fast_open = atoi(value);
+        } else if (strcmp(key, "username") == 0) {
+            strncpy(config->username, value, sizeof(config->username) - 1);
         } else if (strcmp(key, "connection_timeout") == 0) {
             config->connection_timeout = atoi(value);
         } else if (strcmp(key, "retry_attempts") == 0) {
@@ -62,6 +68,9 @@ void print_config(const ClientConfig* config) {
     printf("=== CONFIGURAZIONE CLIENT ===\n");
     printf("Server IP: %s\n", config->server_ip);
     printf("Porta: %d\n", config->port);
+    printf("Socket unix: %s\n", config->unix_socket[0] ? config->unix_socket : "(non usato)");
+    printf("TCP Fast Open: %s\n", config->fast_open ? "attivo" : "disattivato");
+    printf("Username automatico: %s\n", config->username[0] ? config->username : "(nessuno)");
     printf("Timeout connessione: %d sec\n", config->connection_timeout);
     printf("Tentativi di riconnessione: %d\n", config->retry_attempts);
     printf("Livello log: %s\n", config->log_level);
@@ -0,0 +1,143 @@
+/*
+ * Microbenchmark del registro dei client: layout originale a 48 byte
+ * (nome in linea con i campi caldi) contro client_info_t di server.h
+ * (solo campi caldi, 16 byte).
+ *
+ * Misura le due operazioni più frequenti sul registro:
+ * - scansione dello stato di tutti i client, come in
+ *   broadcast_to_registered_clients();
+ * - lettura di stato e game_index per indice casuale, come nella
+ *   ricerca di un client da fd.
+ *
+ * Uso: make bench [BENCH_ARGS="numero_client round"]
+ */
+
+#include "server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_CLIENTS 100000
+#define DEFAULT_ROUNDS 200
+
+// Layout precedente: nome e campi caldi nella stessa struttura
+typedef struct {
+    int fd;
+    char name[MAX_PLAYER_NAME];
+    client_status_t status;
+    int game_index;
+    int player_index;
+} legacy_client_t;
+
+// Evita che il compilatore elimini i cicli misurati
+static volatile long sink;
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static long scan_legacy(const legacy_client_t *clients, int count) {
+    long registered = 0;
+    for (int i = 0; i < count; i++) {
+        registered += clients[i].status == CLIENT_REGISTERED;
+    }
+    return registered;
+}
+
+static long scan_hot(const client_info_t *clients, int count) {
+    long registered = 0;
+    for (int i = 0; i < count; i++) {
+        registered += clients[i].status == CLIENT_REGISTERED;
+    }
+    return registered;
+}
+
+static long lookup_legacy(const legacy_client_t *clients, const int *order, int count) {
+    long total = 0;
+    for (int i = 0; i < count; i++) {
+        const legacy_client_t *client = &clients[order[i]];
+        total += client->status + client->game_index;
+    }
+    return total;
+}
+
+static long lookup_hot(const client_info_t *clients, const int *order, int count) {
+    long total = 0;
+    for (int i = 0; i < count; i++) {
+        const client_info_t *client = &clients[order[i]];
+        total += client->status + client->game_index;
+    }
+    return total;
+}
+
+static void report(const char *name, double legacy_us, double hot_us) {
+    printf("%-22s %10.1f us %10.1f us %8.2fx\n", name, legacy_us, hot_us, legacy_us / hot_us);
+}
+
+int main(int argc, char *argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : DEFAULT_CLIENTS;
+    int rounds = argc > 2 ? atoi(argv[2]) : DEFAULT_ROUNDS;
+    if (count <= 0 || rounds <= 0) {
+        fprintf(stderr, "Uso: %s [numero_client] [round]\n", argv[0]);
+        return 1;
+    }
+
+    legacy_client_t *legacy = aligned_alloc(CACHE_LINE_SIZE, count * sizeof(legacy_client_t));
+    client_info_t *hot = aligned_alloc(CACHE_LINE_SIZE, count * sizeof(client_info_t));
+    int *order = malloc(count * sizeof(int));
+    if (!legacy || !hot || !order) {
+        fprintf(stderr, "Memoria insufficiente per %d client\n", count);
+        return 1;
+    }
+
+    // Stesso contenuto nei due layout: un client su tre in partita
+    srand(42);
+    for (int i = 0; i < count; i++) {
+        client_status_t status = (i % 3 == 0) ? CLIENT_IN_GAME : CLIENT_REGISTERED;
+        int game_index = (i % 3 == 0) ? i / 3 : -1;
+        legacy[i] = (legacy_client_t){ .fd = i + 3, .status = status,
+                                       .game_index = game_index, .player_index = -1 };
+        snprintf(legacy[i].name, sizeof(legacy[i].name), "player%d", i);
+        hot[i] = (client_info_t){ .fd = i + 3, .status = status,
+                                  .game_index = game_index, .player_index = -1 };
+        order[i] = i;
+    }
+    for (int i = count - 1; i > 0; i--) {
+        int j = rand() % (i + 1);
+        int tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+
+    double scan_time[2] = { 0, 0 }, lookup_time[2] = { 0, 0 };
+    for (int r = 0; r < rounds; r++) {
+        double t0 = now_us();
+        sink = scan_legacy(legacy, count);
+        double t1 = now_us();
+        sink = scan_hot(hot, count);
+        double t2 = now_us();
+        sink = lookup_legacy(legacy, order, count);
+        double t3 = now_us();
+        sink = lookup_hot(hot, order, count);
+        double t4 = now_us();
+
+        scan_time[0] += t1 - t0;
+        scan_time[1] += t2 - t1;
+        lookup_time[0] += t3 - t2;
+        lookup_time[1] += t4 - t3;
+    }
+
+    printf("%d client, %d round (media per round)\n", count, rounds);
+    printf("%-22s %13s %13s %9s\n", "", "48 byte", "caldi", "speedup");
+    printf("%-22s %13zu %13zu\n", "byte per client", sizeof(legacy_client_t), sizeof(client_info_t));
+    report("scansione stato", scan_time[0] / rounds, scan_time[1] / rounds);
+    report("lookup casuale", lookup_time[0] / rounds, lookup_time[1] / rounds);
+
+    free(order);
+    free(hot);
+    free(legacy);
+    return 0;
+}
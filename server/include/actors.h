@@ -0,0 +1,66 @@
+#ifndef ACTORS_H
+#define ACTORS_H
+
+// ============================================================================
+// SHARD PROPRIETARI DELLE PARTITE (MODELLO AD ATTORI)
+// ============================================================================
+
+/**
+ * Messaggio di una mailbox, da incorporare nella struttura del mittente
+ *
+ * La mailbox è intrusiva: accodare non alloca nulla.
+ */
+typedef struct actor_msg {
+    struct actor_msg *next;             // Uso interno della mailbox
+} actor_msg_t;
+
+/**
+ * Funzione eseguita da uno shard per ogni messaggio della sua mailbox
+ *
+ * @param msg Messaggio passato a actors_post()
+ * @param shard Shard che lo sta eseguendo
+ */
+typedef void (*actor_msg_fn)(actor_msg_t *msg, int shard);
+
+/**
+ * Avvia gli shard, uno per core
+ *
+ * Ogni shard è un thread fissato su un core con una mailbox
+ * multi-producer/single-consumer senza lock: chiunque può accodare,
+ * solo lo shard preleva, in ordine di arrivo. La partita nello slot i
+ * appartiene allo shard actors_shard_of_game(i).
+ *
+ * @param num_shards Numero di shard (<= 0 per usare il numero di core)
+ * @param fn Funzione eseguita per ogni messaggio
+ * @return Numero di shard avviati, -1 se errore
+ */
+int actors_start(int num_shards, actor_msg_fn fn);
+
+/**
+ * Accoda un messaggio nella mailbox di uno shard
+ *
+ * Non blocca mai e non alloca: può essere chiamata da qualsiasi thread,
+ * anche da uno shard verso un altro.
+ *
+ * @param shard Shard destinatario
+ * @param msg Messaggio (non deve essere già in una mailbox)
+ */
+void actors_post(int shard, actor_msg_t *msg);
+
+/**
+ * Shard proprietario di una partita
+ *
+ * @param game_index Slot in server_state.games
+ * @return Indice dello shard, -1 se gli shard non sono attivi o slot non valido
+ */
+int actors_shard_of_game(int game_index);
+
+/**
+ * Shard iniziale di una connessione non ancora legata a partite
+ *
+ * @param fd File descriptor del client
+ * @return Indice dello shard (distribuzione per fd)
+ */
+int actors_home_shard(int fd);
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef CONN_H
+#define CONN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// ============================================================================
+// HANDLE DELLE CONNESSIONI
+// ============================================================================
+
+/**
+ * Riferimento a una connessione client: generazione (32 bit alti) e fd
+ *
+ * Il kernel riassegna il numero di un fd appena chiuso, mentre la
+ * generazione di quel fd avanza a ogni add_client() (valore dispari,
+ * client connesso) e remove_client() (valore pari): un handle salvato in
+ * una partita non raggiunge mai il client arrivato dopo sullo stesso fd.
+ * Un handle valido ha generazione dispari, quindi 0 non lo è mai.
+ */
+typedef struct {
+    uint64_t value;
+} conn_t;
+
+// Nessuna connessione
+#define CONN_NONE ((conn_t){ 0 })
+#define CONN_IS_NONE(conn) ((conn).value == 0)
+#define CONN_EQUAL(a, b) ((a).value == (b).value)
+
+// Struttura e non intero: passare un fd dove serve un handle non compila
+#define CONN_MAKE(fd, generation) \
+    ((conn_t){ ((uint64_t)(uint32_t)(generation) << 32) | (uint32_t)(fd) })
+#define CONN_FD(conn) ((int)(uint32_t)(conn).value)
+#define CONN_GENERATION(conn) ((uint32_t)((conn).value >> 32))
+
+/**
+ * Handle del client attualmente connesso su un fd
+ *
+ * @param fd File descriptor del client
+ * @return Handle, o CONN_NONE se sul fd non c'è un client
+ * @note Senza lock: per il client che si sta servendo è sempre esatto
+ */
+conn_t conn_of_fd(int fd);
+
+/**
+ * Verifica che un handle indichi ancora la stessa connessione (O(1), senza lock)
+ *
+ * Per un esito stabile serve un lock che escluda remove_client() (es.
+ * clients_lock) o, come in outbound_enqueue_conn(), il lock della coda di
+ * uscita del fd.
+ *
+ * @param conn Handle da verificare
+ * @return true se la connessione è ancora quella dell'handle
+ */
+bool conn_is_live(conn_t conn);
+
+#endif
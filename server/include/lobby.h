@@ -0,0 +1,68 @@
+#ifndef LOBBY_H
+#define LOBBY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../../shared/include/protocol.h"
+
+// ============================================================================
+// SNAPSHOT DELLA LOBBY (LETTURE SENZA LOCK)
+// ============================================================================
+
+// Partite elencate al più in una risposta: il payload non può superare MAX_MESSAGE_SIZE
+#define MAX_LISTED_GAMES \
+    ((int)((MAX_MESSAGE_SIZE - sizeof(response_list_games_t)) / sizeof(game_info_t)))
+
+/**
+ * Risposta a MSG_LIST_GAMES già serializzata, immutabile dopo la pubblicazione
+ *
+ * Chi modifica la lista di attesa pubblica una nuova versione scambiando
+ * il puntatore corrente (stile RCU). I buffer non vengono mai liberati:
+ * uno snapshot superato torna riutilizzabile quando nessun lettore ne
+ * tiene più un riferimento, quindi la memoria resta valida anche per un
+ * lettore che ha caricato un puntatore ormai vecchio.
+ */
+typedef struct lobby_snapshot {
+    struct lobby_snapshot *next;        // Tutti i buffer allocati (solo sotto lobby_lock)
+    int refs;                           // Lettori che stanno usando lo snapshot (atomico)
+    uint64_t version;                   // Versione crescente, una per pubblicazione
+    int waiting;                        // Partite in attesa (anche oltre MAX_LISTED_GAMES)
+    size_t size;                        // Byte validi in data
+    uint8_t data[sizeof(response_list_games_t) + MAX_LISTED_GAMES * sizeof(game_info_t)];
+} lobby_snapshot_t;
+
+/**
+ * Pubblica lo snapshot iniziale (lobby vuota)
+ *
+ * @return 0 se successo, -1 se errore di allocazione
+ */
+int lobby_init(void);
+
+/**
+ * Serializza la lista di attesa corrente e la pubblica come nuova versione
+ *
+ * Da chiamare dopo ogni modifica della lista di attesa. Costo O(partite
+ * elencate); alloca solo se tutti i buffer superati sono ancora in uso.
+ *
+ * @note Richiede che server_state.lobby_lock sia già acquisito
+ */
+void lobby_publish(void);
+
+/**
+ * Acquisisce lo snapshot corrente senza lock
+ *
+ * Lo snapshot resta invariato fino a lobby_release(), anche se nel
+ * frattempo ne viene pubblicato uno nuovo.
+ *
+ * @return Snapshot corrente (mai NULL dopo lobby_init())
+ */
+const lobby_snapshot_t *lobby_acquire(void);
+
+/**
+ * Rilascia uno snapshot ottenuto con lobby_acquire()
+ *
+ * @param snapshot Snapshot da rilasciare
+ */
+void lobby_release(const lobby_snapshot_t *snapshot);
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef NAMES_H
+#define NAMES_H
+
+// ============================================================================
+// INDICE DEI NOMI DEI GIOCATORI
+// ============================================================================
+
+/**
+ * Tabella hash a indirizzamento aperto (linear probing) sui nomi dei
+ * client registrati. Ogni elemento memorizza il fd del client e l'hash
+ * del nome: il fd resta stabile anche quando remove_client() sposta il
+ * client in un altro slot, e lo slot si ricava da find_client_by_fd().
+ *
+ * La crescita è incrementale: quando il fattore di carico supera 3/4 si
+ * alloca una tabella di dimensione doppia e ogni operazione successiva
+ * sposta al più un numero fisso di slot dalla vecchia. Nessuna chiamata
+ * fa quindi un rehash completo tenendo server_state.clients_lock.
+ *
+ * Tutte le funzioni richiedono che server_state.clients_lock sia già acquisito.
+ */
+
+/**
+ * Alloca la tabella iniziale
+ *
+ * @return 0 se successo, -1 se errore
+ */
+int names_init(void);
+
+/**
+ * Cerca un client registrato per nome
+ *
+ * @param name Nome del giocatore (al più MAX_PLAYER_NAME byte)
+ * @return Indice nell'array clients, o -1 se il nome non è in uso
+ */
+int names_find(const char *name);
+
+/**
+ * Aggiunge il nome di un client appena registrato
+ *
+ * Il chiamante ha già verificato con names_find() che il nome sia libero.
+ *
+ * @param name Nome del giocatore
+ * @param fd File descriptor del client
+ * @return 0 se successo, -1 se errore di allocazione
+ */
+int names_insert(const char *name, int fd);
+
+/**
+ * Rimuove il nome di un client (disconnessione)
+ *
+ * @param name Nome del giocatore
+ * @param fd File descriptor del client
+ */
+void names_remove(const char *name, int fd);
+
+#endif
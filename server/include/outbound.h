@@ -0,0 +1,116 @@
+#ifndef OUTBOUND_H
+#define OUTBOUND_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include "../../shared/include/protocol.h"
+#include "conn.h"
+
+// ============================================================================
+// CODE DI USCITA PER CONNESSIONE
+// ============================================================================
+
+// Profondità massima di default della coda di un client (in messaggi)
+#define OUTBOUND_DEFAULT_MAX_FRAMES 256
+
+/**
+ * Contatori delle connessioni rifiutate (server pieno)
+ */
+typedef struct {
+    unsigned long rejected;             // Connessioni rifiutate dall'avvio
+    unsigned long lingering;            // Rifiutate in attesa di chiusura
+    unsigned long timed_out;            // Chiuse allo scadere del timer (client non ha chiuso)
+} outbound_reject_stats_t;
+
+/**
+ * Inizializza le code di uscita e avvia il thread di scrittura
+ *
+ * Il thread di scrittura completa, tramite una propria istanza epoll
+ * (EPOLLOUT), gli invii rimasti a metà perché il socket era pieno,
+ * gestisce la chiusura differita delle connessioni rifiutate e fa
+ * avanzare la timer wheel delle connessioni (vedi timers.h).
+ *
+ * @return 0 se successo, -1 se errore
+ */
+int outbound_init(void);
+
+/**
+ * Prepara la coda di uscita di una nuova connessione
+ *
+ * @param client_fd File descriptor del client
+ */
+void outbound_open(int client_fd);
+
+/**
+ * Scarta la coda di uscita di una connessione che sta per essere chiusa
+ *
+ * Da chiamare prima di close(): dopo il ritorno nessun thread scrive
+ * più sul file descriptor, che può quindi essere riutilizzato.
+ *
+ * @param client_fd File descriptor del client
+ */
+void outbound_close(int client_fd);
+
+/**
+ * Accoda uno o più messaggi nella coda di uscita di un client
+ *
+ * Non esegue alcuna syscall di scrittura: copia i messaggi e segna la
+ * coda come da svuotare. Può quindi essere chiamata anche tenendo i
+ * lock dello stato del server (partite, lobby, client). Se la coda supera la profondità massima il client
+ * è considerato troppo lento: i messaggi vengono scartati e la
+ * connessione chiusa con shutdown(), così il percorso di lettura
+ * esegue la normale disconnessione.
+ *
+ * @param client_fd File descriptor del client destinatario
+ * @param frames Array di messaggi
+ * @param count Numero di messaggi
+ * @return Byte accodati (header + payload), -1 se errore
+ */
+ssize_t outbound_enqueue(int client_fd, const protocol_frame_t *frames, size_t count);
+
+/**
+ * Come outbound_enqueue(), verso la connessione indicata da un handle
+ *
+ * I messaggi vengono scartati se la connessione è stata chiusa, anche se
+ * il suo fd è già di un altro client: la verifica avviene sotto il lock
+ * della coda, quindi è esatta anche senza altri lock.
+ *
+ * @param conn Handle della connessione destinataria
+ * @param frames Array di messaggi
+ * @param count Numero di messaggi
+ * @return Byte accodati (header + payload), -1 se errore o connessione chiusa
+ */
+ssize_t outbound_enqueue_conn(conn_t conn, const protocol_frame_t *frames, size_t count);
+
+/**
+ * Svuota le code segnate dal thread corrente con outbound_enqueue()
+ *
+ * Scrive in modo non bloccante tutto ciò che il socket accetta; il resto
+ * passa al thread di scrittura. Da chiamare senza tenere lock dello stato del server.
+ */
+void outbound_flush_pending(void);
+
+/**
+ * Rifiuta una connessione senza mai bloccare il chiamante
+ *
+ * Accoda i messaggi (es. ERR_SERVER_FULL), esegue shutdown(SHUT_WR)
+ * appena sono stati scritti e affida il socket al thread di scrittura,
+ * che lo chiude quando il client chiude a sua volta o, al più tardi,
+ * allo scadere di un timer. Il socket non deve essere registrato come
+ * client: dopo la chiamata appartiene alle code di uscita.
+ *
+ * @param client_fd File descriptor appena accettato
+ * @param frames Messaggi da inviare prima della chiusura
+ * @param count Numero di messaggi
+ */
+void outbound_reject(int client_fd, const protocol_frame_t *frames, size_t count);
+
+/**
+ * Legge i contatori delle connessioni rifiutate
+ *
+ * @param stats Struttura da riempire
+ */
+void outbound_get_reject_stats(outbound_reject_stats_t *stats);
+
+#endif
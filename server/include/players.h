@@ -0,0 +1,66 @@
+#ifndef PLAYERS_H
+#define PLAYERS_H
+
+#include <stdint.h>
+
+// ============================================================================
+// NOMI INTERNATI DEI GIOCATORI
+// ============================================================================
+
+/*
+ * Ogni client registrato riceve un ID a 32 bit che indica il suo nome in
+ * una tabella a indirizzi stabili: le partite tengono gli ID (4 byte) al
+ * posto dei nomi (MAX_PLAYER_NAME byte) e confrontano giocatori con un
+ * confronto tra interi.
+ *
+ * Un ID ha un contatore di riferimenti: uno per la registrazione e uno per
+ * ogni partita che lo usa (come giocatore o richiedente di join). Il nome
+ * resta valido, e l'ID non viene riassegnato, finché esiste un riferimento.
+ * La tabella ha un lock interno, il più interno di tutti: le funzioni si
+ * possono chiamare tenendo qualunque altro lock.
+ */
+
+// ID di un giocatore (PLAYER_NONE se nessuno)
+typedef uint32_t player_id_t;
+
+#define PLAYER_NONE 0
+
+/**
+ * Riserva la tabella per server_state.max_clients giocatori
+ *
+ * @return 0 se successo, -1 se la riserva degli indirizzi fallisce
+ */
+int players_init(void);
+
+/**
+ * Interna il nome di un client appena registrato
+ *
+ * @param name Nome del giocatore (già validato e unico tra i registrati)
+ * @return ID con un riferimento (della registrazione), o PLAYER_NONE se la tabella è piena
+ */
+player_id_t players_add(const char *name);
+
+/**
+ * Aggiunge un riferimento a un ID
+ *
+ * @param id ID di cui il chiamante possiede già un riferimento (es. il
+ *           proprio, finché il client è registrato)
+ */
+void players_ref(player_id_t id);
+
+/**
+ * Rilascia un riferimento: all'ultimo l'ID torna libero
+ *
+ * @param id ID da rilasciare (PLAYER_NONE viene ignorato)
+ */
+void players_release(player_id_t id);
+
+/**
+ * Nome di un giocatore
+ *
+ * @param id ID di cui esiste un riferimento per tutta la durata dell'uso
+ * @return Nome del giocatore (stringa vuota per PLAYER_NONE)
+ */
+const char *players_name(player_id_t id);
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "../../shared/include/constants.h"
+#include "../../shared/include/protocol.h"
+
+// ============================================================================
+// REACTOR EPOLL
+// ============================================================================
+
+/**
+ * Stato di una connessione gestita dal reactor
+ *
+ * I byte ricevuti vengono accumulati nel decoder finché non formano
+ * uno o più messaggi completi (header + payload).
+ */
+typedef struct {
+    int fd;                             // Socket file descriptor del client
+    protocol_decoder_t decoder;         // Buffer di ricezione e decodifica
+} connection_t;
+
+/**
+ * Avvia il reactor epoll e gestisce le connessioni client
+ *
+ * Tutti i socket (server e client) vengono registrati su un'unica
+ * istanza epoll servita da un pool fisso di thread. Ogni socket client
+ * è registrato con EPOLLONESHOT: un solo thread alla volta lavora su
+ * una connessione, quindi i messaggi di uno stesso client vengono
+ * gestiti in ordine. Non ritorna mai.
+ *
+ * @param server_fd File descriptor del socket server
+ * @param num_threads Numero di thread del reactor (<= 0 per usare il numero di core)
+ */
+void reactor_run(int server_fd, int num_threads);
+
+/**
+ * Avvia il reactor in modalità shard (uno per core)
+ *
+ * Ogni shard ha il proprio socket in ascolto SO_REUSEPORT sulla stessa
+ * porta, la propria istanza epoll e un thread fissato su un core: il
+ * kernel distribuisce le nuove connessioni tra gli shard, eliminando il
+ * collo di bottiglia del singolo accept. Client e partite restano nello
+ * stato globale condiviso, quindi ogni client vede tutta la lobby.
+ * Non ritorna mai.
+ *
+ * @param server_fd Socket creato da init_server() (con SO_REUSEPORT), usato dallo shard 0
+ * @param num_shards Numero di shard (<= 0 per usare il numero di core)
+ */
+void reactor_run_shards(int server_fd, int num_shards);
+
+/**
+ * Avvia il reactor con un pool di worker per gli handler
+ *
+ * I thread del reactor si limitano a leggere i socket nei decoder; la
+ * decodifica e gli handler passano a un pool fisso di worker con deque
+ * per-worker e work-stealing (vedi workers.h). Una connessione viene
+ * riarmata in epoll solo dopo che il worker ha gestito i suoi messaggi,
+ * quindi l'ordine per client è preservato. Non ritorna mai.
+ *
+ * @param server_fd File descriptor del socket server
+ * @param io_threads Thread del reactor (<= 0 per usarne uno)
+ * @param num_workers Worker del pool (<= 0 per usare il numero di core)
+ */
+void reactor_run_pool(int server_fd, int io_threads, int num_workers);
+
+/**
+ * Avvia il reactor con gli shard proprietari delle partite (actors.h)
+ *
+ * Come con il pool, i thread del reactor leggono soltanto; i messaggi
+ * di una connessione vengono poi gestiti dallo shard che possiede la
+ * partita che toccano (quella richiesta per un join, altrimenti quella
+ * del client). Mosse, accettazioni e abbandoni di una partita girano
+ * quindi sempre sullo stesso thread; i join tra shard diversi diventano
+ * il passaggio della connessione nella mailbox del proprietario. Non
+ * ritorna mai.
+ *
+ * @param server_fd File descriptor del socket server
+ * @param io_threads Thread del reactor (<= 0 per usarne uno)
+ * @param num_shards Numero di shard (<= 0 per usare il numero di core)
+ */
+void reactor_run_actors(int server_fd, int io_threads, int num_shards);
+
+#endif
@@ -10,50 +10,145 @@
 #include "../../shared/include/protocol.h"
 #include "../../shared/include/game_logic.h"
 #include "utils.h"
+#include "conn.h"
+#include "players.h"
 
 // ============================================================================
 // STRUTTURE DATI SERVER
 // ============================================================================
 
-/**
- * Informazioni su ogni client connesso
+/*
+ * LOCK DELLO STATO CONDIVISO
+ *
+ * - server_state.clients_lock (registro dei client): clients, num_clients,
+ *   client_by_fd e indice dei nomi. Tenuto solo per sezioni brevi.
+ * - server_state.lobby_lock: slot liberi e segmenti della tabella delle
+ *   partite, lista delle partite in attesa, num_games e generazione dei
+ *   game_id. Chi lo tiene pubblica
+ *   anche lo snapshot della lobby, che i lettori usano senza lock.
+ * - game_session_t.lock: tutti gli altri campi della propria partita. Si
+ *   acquisisce solo con lock_game_slot() e si rilascia con unlock_game()
+ *   (tables.h), che tengono valido lo slot anche se il suo segmento viene
+ *   ritirato nel frattempo.
+ *   Partite diverse procedono in parallelo (mosse comprese). Con
+ *   io_mode=actors i messaggi di una partita girano sul suo shard, quindi
+ *   questo lock in pratica non è mai conteso.
+ *
+ * Ordine di acquisizione: lock di una partita -> lobby_lock -> clients_lock.
+ * Non si tengono mai i lock di due partite insieme. Le code di uscita
+ * (outbound.h) e la timer wheel (timers.h) hanno lock propri, sempre più
+ * interni di questi.
+ *
+ * status, game_index e player_index di un client legato a una partita
+ * (giocatore o richiedente di join) cambiano solo tenendo anche il lock di
+ * quella partita; un client non legato a partite cambia stato solo dal
+ * proprio thread. Vedi lock_client_game() in server.c.
+ */
+
+// Dimensione di una riga di cache: i campi caldi non la condividono con quelli freddi
+#define CACHE_LINE_SIZE 64
+
+/**
+ * Campi caldi di ogni client connesso
+ *
+ * Letti a ogni richiesta e nelle scansioni del registro: 16 byte, quindi
+ * quattro client per riga di cache. Il nome sta in client_cold_t, nello
+ * stesso indice di server_state.clients_cold.
  */
 typedef struct {
     int fd;                             // Socket file descriptor
-    char name[MAX_PLAYER_NAME];         // Nome giocatore (se registrato)
     client_status_t status;             // Stato corrente del client
-    int game_index;                     // Indice in games[] (-1 se non in partita)
+    int game_index;                     // Indice in games[] (-1 se nessuna partita; anche
+                                        // la partita richiesta se CLIENT_REQUESTING_JOIN)
     int player_index;                   // 0 o 1 nella partita (quale giocatore è)
+} client_info_t;
 
-    //NOTE: Potrebbero essere aggiunti altri campi in futuro
+/**
+ * Campi freddi di un client, usati solo in registrazione e nei messaggi
+ *
+ * Riempiti fino a una riga di cache: un segmento della tabella occupa
+ * così un numero intero di pagine (vedi CLIENT_SEGMENT_SLOTS).
+ */
+typedef struct {
+    char name[MAX_PLAYER_NAME];         // Nome giocatore (se registrato)
+    player_id_t player_id;              // Nome internato (PLAYER_NONE se non registrato)
+
+    //NOTE: Potrebbero essere aggiunti altri campi in futuro, al posto del riempimento
     //uint32_t seq_id;                  // Sequence ID per messaggi
     //pthread_t thread_id;              // ID del thread che gestisce questo client
-} client_info_t;
+    uint8_t reserved[CACHE_LINE_SIZE - MAX_PLAYER_NAME - sizeof(player_id_t)];
+} client_cold_t;
+
+_Static_assert(sizeof(client_cold_t) == CACHE_LINE_SIZE, "un client freddo per riga di cache");
 
 /**
  * Informazioni su ogni partita attiva
+ *
+ * Una partita occupa esattamente una riga di cache: giocatori come ID
+ * internati (players.h), tabellone e stato del gioco compatti
+ * (game_packed_t), un lock da 4 byte al posto di pthread_mutex_t e nessuna
+ * stringa. Il game_id si ricava da slot e generazione (game_session_id()).
  */
 typedef struct {
-    game_state_t state;                 // Stato del gioco (da game_logic.h)
-    int player_fds[2];                  // Socket dei due giocatori [0]=creatore, [1]=joiner
-    int active;                         // 1 se partita attiva, 0 se slot libero
+    uint32_t lock;                      // Lock della partita (vedi ordine dei lock sopra)
+    uint32_t generation;                // Generazione codificata nel game_id corrente
+    game_packed_t state;                // Stato del gioco (da game_logic.h): giocatori e tabellone
+    uint8_t active;                     // 1 se partita attiva, 0 se slot libero
+    uint8_t waiting;                    // 1 se collegata nella lista di attesa (lobby_lock)
+    conn_t player_conns[2];             // Connessioni dei giocatori [0]=creatore, [1]=joiner
+                                        // (CONN_NONE se assente)
+    
+    // Join pendente
+    conn_t pending_join_conn;           // Connessione di chi vuole joinare (CONN_NONE se nessuno)
+    player_id_t pending_join_id;        // Giocatore in attesa di accept (PLAYER_NONE se nessuno)
     
-    // Gestione pending join (giocatore in attesa di accept)
-    int pending_join_fd;                // FD del giocatore che vuole joinare (-1 se nessuno)
-    char pending_join_name[MAX_PLAYER_NAME]; // Nome del giocatore in attesa
-} game_session_t;
+    // Campi protetti da server_state.lobby_lock
+    int next_free;                      // Slot libero successivo (-1 se ultimo o se attiva)
+    // Lista intrusiva delle partite in attesa (GAME_WAITING), in ordine di creazione
+    int wait_prev;                      // Partita in attesa precedente (-1 se prima)
+    int wait_next;                      // Partita in attesa successiva (-1 se ultima)
+} __attribute__((aligned(CACHE_LINE_SIZE))) game_session_t;
+
+_Static_assert(sizeof(game_session_t) == CACHE_LINE_SIZE, "una partita per riga di cache");
+
+/*
+ * Partita a cui è legato il client di un fd, in server_state.client_game
+ *
+ * Copia di game_index (32 bit bassi) e player_index (32 bit alti) del
+ * client, scritta insieme a loro sotto clients_lock e letta senza lock dal
+ * thread che gestisce la connessione: una mossa trova la partita senza
+ * passare dal registro dei client. -1 in entrambi se nessuna partita.
+ */
+#define CLIENT_GAME_MAKE(game_index, player_index) \
+    (((uint64_t)(uint32_t)(player_index) << 32) | (uint32_t)(game_index))
+#define CLIENT_GAME_INDEX(ref) ((int)(uint32_t)(ref))
+#define CLIENT_GAME_PLAYER(ref) ((int)(uint32_t)((ref) >> 32))
+#define CLIENT_GAME_NONE CLIENT_GAME_MAKE(-1, -1)
 
 /**
  * Stato globale del server
  */
 typedef struct {
-    client_info_t *clients;             // Array dinamico di client (allocato con malloc)
-    game_session_t *games;              // Array dinamico di partite (allocato con malloc)
-    int max_clients;                    // Capacità massima client (da config)
-    int max_games;                      // Capacità massima partite (da config)
+    client_info_t *clients;             // Campi caldi dei client (tabella segmentata, tables.h)
+    client_cold_t *clients_cold;        // Campi freddi, stesso indice di clients
+    int *client_by_fd;                  // Indice fd -> slot in clients (-1 se nessun client)
+    int client_by_fd_size;              // Dimensione dell'indice (fd massimo + 1)
+    uint32_t *conn_generation;          // Generazione di ogni fd per gli handle conn_t (conn.h)
+    uint64_t *client_game;              // Partita del client di ogni fd (CLIENT_GAME_*), senza lock
+    game_session_t *games;              // Partite (tabella segmentata, indirizzi stabili)
+    int max_clients;                    // Tetto dei client (da config): memoria riservata, non occupata
+    int max_games;                      // Tetto delle partite (da config)
     int num_clients;                    // Numero di client attualmente connessi
     int num_games;                      // Numero di partite attualmente attive
-    pthread_mutex_t mutex;              // Mutex per proteggere lo stato condiviso
+    int waiting_head;                   // Partita in attesa più vecchia (-1 se nessuna)
+    int waiting_tail;                   // Partita in attesa più recente (-1 se nessuna)
+    int num_waiting;                    // Partite nella lista di attesa
+    int unix_fd;                        // Listener AF_UNIX (-1 se unix_socket non impostato)
+    // Ogni lock su una riga propria: chi prende l'uno non invalida la riga dell'altro
+    // Registro dei client (clients, indici per fd e nome)
+    pthread_mutex_t clients_lock __attribute__((aligned(CACHE_LINE_SIZE)));
+    // Slot liberi, partite in attesa, num_games
+    pthread_mutex_t lobby_lock __attribute__((aligned(CACHE_LINE_SIZE)));
 } server_state_t;
 
 // Stato globale del server (dichiarato extern, definito in server.c)
@@ -66,15 +161,17 @@ extern server_state_t server_state;
 /**
  * Inizializza lo stato globale del server
  * 
- * Alloca dinamicamente gli array per client e partite in base
- * ai limiti configurati (max_clients, max_games).
+ * Riserva le tabelle segmentate di client e partite (tables.h) fino ai
+ * limiti configurati (max_clients, max_games): la memoria viene occupata
+ * un segmento alla volta, secondo il carico.
  */
 void init_server_state();
 
 /**
  * Inizializza e configura il socket del server
  * 
- * Crea il socket, configura le opzioni (SO_REUSEADDR), effettua
+ * Crea il socket, configura le opzioni (SO_REUSEADDR e, con più
+ * shard, SO_REUSEPORT), effettua
  * il bind su una porta disponibile (con fallback automatico) e
  * si mette in ascolto.
  * 
@@ -83,11 +180,69 @@ void init_server_state();
  */
 int init_server(int port);
 
+/**
+ * Abilita TCP_FASTOPEN e TCP_DEFER_ACCEPT su un socket in ascolto
+ * 
+ * Con tcp_fastopen il kernel consegna insieme alla connessione i dati
+ * arrivati nel SYN (MSG_REGISTER del client); con defer_accept il socket
+ * viene restituito da accept solo quando il primo messaggio è arrivato.
+ * Gli errori vengono solo segnalati: il listener resta utilizzabile.
+ * 
+ * @param listen_fd Socket TCP non ancora in ascolto
+ */
+void configure_fast_onboarding(int listen_fd);
+
+/**
+ * Crea un ulteriore socket in ascolto per uno shard del reactor
+ * 
+ * Il socket usa SO_REUSEPORT e si lega alla porta già scelta da
+ * init_server(): il kernel bilancia le connessioni tra tutti i listener.
+ * 
+ * @param port Porta su cui mettersi in ascolto (server_config.port)
+ * @return File descriptor del socket, o -1 in caso di errore
+ */
+int init_shard_listener(int port);
+
+/**
+ * Crea il socket AF_UNIX in ascolto per i processi sulla stessa macchina
+ * 
+ * Le connessioni locali (bot, gateway) saltano lo stack TCP ma usano lo
+ * stesso protocollo e gli stessi handler. Un percorso che inizia con '@'
+ * indica un socket nel namespace astratto di Linux (nessun file creato);
+ * altrimenti un eventuale file rimasto da un'esecuzione precedente viene
+ * rimosso prima del bind.
+ * 
+ * @param path Percorso del socket (unix_socket dalla configurazione)
+ * @return File descriptor del socket, o -1 in caso di errore
+ */
+int init_unix_server(const char *path);
+
+/**
+ * Backlog da passare a listen()
+ * 
+ * @return backlog_size dalla configurazione, o max_clients se non impostato
+ */
+int listen_backlog(void);
+
+/**
+ * Segnala se la coda di accept del kernel è satura
+ * 
+ * Da chiamare a ogni risveglio dell'acceptor, prima di svuotare la coda:
+ * al più una volta al secondo legge con TCP_INFO la lunghezza della coda
+ * di un socket in ascolto e, se ha raggiunto il backlog, scrive un avviso
+ * con il contatore di sistema ListenOverflows (connessioni scartate dal
+ * kernel). Le altre chiamate costano solo una lettura dell'orologio.
+ * 
+ * @param listen_fd Socket in ascolto
+ */
+void report_accept_queue_overflow(int listen_fd);
+
 /**
  * Avvia il server e gestisce le connessioni client
  * 
  * Loop infinito che accetta connessioni, crea un thread per ogni
- * client connesso e fa il detach del thread.
+ * client connesso e fa il detach del thread. Se è attivo il listener
+ * AF_UNIX, un secondo thread esegue lo stesso loop su di esso.
  * 
  * @param server_fd File descriptor del socket server
  */
@@ -104,6 +259,109 @@ void start_server(int server_fd);
  */
 void *handle_client(void *arg);
 
+/**
+ * Smista un messaggio ricevuto all'handler appropriato
+ * 
+ * Punto di ingresso comune per tutte le modalità di I/O (thread per
+ * client o reactor epoll): il protocollo e gli handler restano identici.
+ * 
+ * @param client_fd File descriptor del client mittente
+ * @param header Header del messaggio (già in host byte order)
+ * @param payload Payload del messaggio (NULL se assente)
+ * @return false se il client ha chiesto la disconnessione (MSG_QUIT), true altrimenti
+ */
+bool dispatch_message(int client_fd, const protocol_header_t *header, const void *payload);
+
+/**
+ * Estrae e gestisce tutti i messaggi completi presenti nel decoder
+ * 
+ * Ogni messaggio viene passato a dispatch_message() senza copiare il
+ * payload; i byte di un messaggio incompleto restano nel decoder.
+ * Usata da tutte le modalità di I/O dopo ogni lettura dal socket.
+ * Dopo ogni messaggio svuota le code di uscita con outbound_flush_pending().
+ * 
+ * @param client_fd File descriptor del client mittente
+ * @param decoder Decoder con i nuovi byte già ricevuti
+ * @return true se la connessione resta aperta, false se va chiusa
+ *         (MSG_QUIT o messaggio non valido: il cleanup è già stato fatto)
+ */
+bool dispatch_decoded_messages(int client_fd, protocol_decoder_t *decoder);
+
+/**
+ * Come dispatch_decoded_messages(), ma eseguita da uno shard (actors.h)
+ * 
+ * Prima di ogni messaggio controlla quale partita toccherà: se appartiene
+ * a un altro shard il messaggio resta nel decoder, la funzione ritorna e
+ * il chiamante deve passare la connessione a *next_shard.
+ * 
+ * @param client_fd File descriptor del client mittente
+ * @param decoder Decoder con i messaggi da gestire
+ * @param shard Shard corrente (-1 = nessun instradamento)
+ * @param next_shard Shard a cui passare la connessione (-1 se nessuno)
+ * @return true se la connessione resta aperta, false se va chiusa
+ */
+bool dispatch_decoded_messages_on_shard(int client_fd, protocol_decoder_t *decoder,
+                                        int shard, int *next_shard);
+
+/**
+ * Invia un messaggio a un client tramite il motore di I/O attivo
+ * 
+ * Unico punto di uscita usato dagli handler: con io_mode=uring il
+ * messaggio viene accodato sul ring, altrimenti nella coda di uscita del
+ * client (vedi outbound.h). Non scrive mai sul socket, quindi può essere
+ * chiamata tenendo qualunque lock dello stato del server.
+ * 
+ * @param client_fd File descriptor del client destinatario
+ * @param msg_type Tipo di messaggio (MSG_*)
+ * @param payload Puntatore al payload (NULL se nessun payload)
+ * @param payload_size Dimensione del payload in bytes
+ * @return Byte inviati o accodati (header + payload), -1 se errore
+ */
+ssize_t send_to_client(int client_fd, uint8_t msg_type, const void *payload, size_t payload_size);
+
+/**
+ * Invia un messaggio a una connessione salvata (es. l'avversario in una partita)
+ * 
+ * Come send_to_client(), ma il messaggio viene scartato se la connessione
+ * dell'handle è stata chiusa nel frattempo, anche se il suo fd è già stato
+ * riassegnato a un altro client.
+ * 
+ * @param conn Handle della connessione destinataria
+ * @param msg_type Tipo di messaggio (MSG_*)
+ * @param payload Puntatore al payload (NULL se nessun payload)
+ * @param payload_size Dimensione del payload in bytes
+ * @return Byte accodati (header + payload), -1 se errore o connessione chiusa
+ */
+ssize_t send_to_conn(conn_t conn, uint8_t msg_type, const void *payload, size_t payload_size);
+
+/**
+ * Invia più messaggi allo stesso client tramite il motore di I/O attivo
+ * 
+ * Fuori da io_uring i messaggi vengono accodati insieme e scritti
+ * con un'unica sendmsg() allo svuotamento della coda.
+ * 
+ * @param client_fd File descriptor del client destinatario
+ * @param frames Messaggi da inviare, in ordine
+ * @param count Numero di messaggi
+ * @return Byte inviati o accodati in totale, -1 se errore
+ */
+ssize_t send_batch_to_client(int client_fd, const protocol_frame_t *frames, size_t count);
+
+/**
+ * Rifiuta una connessione perché il server è pieno
+ * 
+ * Accoda ERR_SERVER_FULL e affida il socket a outbound_reject(), che
+ * esegue shutdown(SHUT_WR) e la chiusura differita: l'acceptor non si
+ * blocca mai, quindi si può chiamare dal thread del reactor e del ring
+ * io_uring. Nessuna attesa e nessuna scrittura su stdout; i contatori
+ * dei rifiuti (outbound_get_reject_stats()) vanno nel log solo a livello
+ * DEBUG, per non inondarlo proprio durante un sovraccarico.
+ * 
+ * @param client_fd File descriptor della connessione da rifiutare
+ * @param num_clients Client connessi, letti dal chiamante sotto server_state.clients_lock
+ */
+void reject_client_server_full(int client_fd, int num_clients);
+
 /**
  * Tenta il bind su porte successive fino a trovarne una libera
  * 
@@ -121,30 +379,39 @@ int bind_to_available_port(int server_fd, struct sockaddr_in *address, int start
 /**
  * Trova un client per file descriptor
  * 
+ * O(1): legge l'indice client_by_fd, mantenuto da add_client() e
+ * remove_client() anche quando la rimozione sposta un altro client.
+ * 
  * @param fd File descriptor da cercare
  * @return Indice nell'array clients, o -1 se non trovato
- * @note Richiede che server_state.mutex sia già acquisito dal chiamante
+ * @note Richiede che server_state.clients_lock sia già acquisito dal chiamante
  */
 int find_client_by_fd(int fd);
 
 /**
  * Trova un client per nome giocatore
  * 
+ * O(1) tramite l'indice hash dei nomi (names.h), aggiornato da
+ * handle_register() e remove_client().
+ * 
  * @param name Nome del giocatore da cercare
  * @return Indice nell'array clients, o -1 se non trovato
- * @note Richiede che server_state.mutex sia già acquisito dal chiamante
+ * @note Richiede che server_state.clients_lock sia già acquisito dal chiamante
  */
 int find_client_by_name(const char *name);
 
 /**
  * Aggiunge un nuovo client all'array
  * 
- * Usa num_clients come indice diretto (O(1)) e inizializza
- * lo stato del client a CLIENT_CONNECTED.
+ * Usa num_clients come indice diretto (O(1)), estendendo la tabella di
+ * un segmento se serve, lo registra nell'indice per fd e inizializza lo
+ * stato del client a CLIENT_CONNECTED.
  * 
  * @param fd File descriptor del socket client
- * @return Indice nell'array clients, o -1 se array pieno
- * @note Richiede che server_state.mutex sia già acquisito dal chiamante
+ * @return Indice nell'array clients, -1 se array pieno, -2 se il fd è oltre
+ *         l'indice per fd (limite dei descrittori, non del server: niente
+ *         ERR_SERVER_FULL, la connessione va chiusa)
+ * @note Richiede che server_state.clients_lock sia già acquisito dal chiamante
  */
 int add_client(int fd);
 
@@ -152,10 +419,13 @@ int add_client(int fd);
  * Rimuove un client e fa cleanup completo
  * 
  * Se il client è in una partita, notifica l'avversario e pulisce
- * la partita. Usa swap con l'ultimo elemento per rimozione O(1).
+ * la partita. Usa swap con l'ultimo elemento per rimozione O(1),
+ * aggiornando l'indice per fd del client spostato. Se registrato,
+ * il nome viene tolto dall'indice dei nomi. Un segmento in coda rimasto
+ * libero torna al sistema (clients_table_fit()).
  * 
  * @param fd File descriptor del client da rimuovere
- * @note Richiede che server_state.mutex sia già acquisito dal chiamante
+ * @note Richiede che server_state.clients_lock sia già acquisito dal chiamante
  */
 void remove_client(int fd);
 
@@ -166,41 +436,80 @@ void remove_client(int fd);
 /**
  * Trova una partita per game_id
  * 
+ * O(1): il game_id codifica slot e generazione, quindi basta decodificarlo
+ * e confrontare la generazione dello slot. Un ID di una partita già
+ * terminata (slot riutilizzato o libero) non viene trovato.
+ * 
  * @param game_id ID univoco della partita da cercare
- * @return Indice nell'array games, o -1 se non trovata
- * @note Richiede che server_state.mutex sia già acquisito dal chiamante
+ * @return Indice nell'array games, o -1 se non trovata (o ID non valido)
+ * @note Se trovata, la partita viene restituita con il suo lock acquisito:
+ *       il chiamante lo rilascia. Da chiamare senza altri lock.
  */
 int find_game_by_id(const char *game_id);
 
+/**
+ * Scrive il game_id di una partita
+ * 
+ * Il game_id non viene memorizzato: si ricava da slot e generazione della
+ * partita, nello stesso formato che decodifica find_game_by_id().
+ * 
+ * @param game Partita con il lock acquisito (o in lista di attesa, sotto lobby_lock)
+ * @param game_id Destinazione (MAX_GAME_ID_LEN byte, terminata da '\0')
+ */
+void game_session_id(const game_session_t *game, char game_id[MAX_GAME_ID_LEN]);
+
+/**
+ * Partita che un messaggio toccherà, per instradarlo al suo shard
+ * 
+ * Per MSG_JOIN_GAME è la partita richiesta, per gli altri messaggi (e per
+ * la disconnessione, header NULL) quella a cui il client è legato. È solo
+ * un'indicazione: gli handler ricontrollano sotto il lock della partita.
+ * 
+ * @param client_fd File descriptor del client mittente
+ * @param header Header del messaggio (NULL per la disconnessione)
+ * @param payload Payload del messaggio (NULL se assente)
+ * @return Slot della partita, o -1 se il messaggio non tocca partite
+ * @note Da chiamare senza altri lock
+ */
+int message_target_game(int client_fd, const protocol_header_t *header, const void *payload);
+
 /**
  * Trova la partita di un client dato il suo FD
  * 
  * @param fd File descriptor del client
  * @return Indice nell'array games, o -1 se il client non è in partita
- * @note Richiede che server_state.mutex sia già acquisito dal chiamante
+ * @note Acquisisce a turno il lock di ogni partita: da chiamare senza altri lock
  */
 int find_game_by_client_fd(int fd); //NOTE: not used
 
 /**
  * Crea una nuova partita
  * 
- * Genera un game_id univoco, inizializza lo stato di gioco e
- * imposta il creatore come player 0.
+ * Genera un game_id univoco ('G', slot in 6 cifre esadecimali e
+ * generazione in 8, assegnata da un contatore crescente), inizializza
+ * lo stato di gioco e imposta il creatore come player 0. Lo slot viene
+ * da games_table_alloc(): il segmento più basso con posti liberi, e un
+ * nuovo segmento se sono tutti pieni.
  * 
- * @param creator_name Nome del giocatore creatore
- * @param creator_fd File descriptor del creatore
- * @return Indice nell'array games, o -1 se array pieno
- * @note Richiede che server_state.mutex sia già acquisito dal chiamante
+ * @param creator ID del giocatore creatore (la partita prende un riferimento)
+ * @param creator_conn Connessione del creatore
+ * @return Indice nell'array games, o -1 se la tabella è al tetto max_games
+ * @note La partita viene restituita con il suo lock acquisito (il chiamante
+ *       lo rilascia). Da chiamare senza altri lock.
  */
-int create_game(const char *creator_name, int creator_fd);
+int create_game(player_id_t creator, conn_t creator_conn);
 
 /**
  * Pulisce una partita terminata
  * 
- * Resetta lo stato dei client coinvolti a CLIENT_REGISTERED,
- * marca la partita come non attiva e decrementa il contatore.
+ * Resetta lo stato dei client coinvolti a CLIENT_REGISTERED (un
+ * eventuale richiedente di join riceve un rifiuto), marca la partita
+ * come non attiva, rimette lo slot tra i liberi del suo segmento
+ * (games_table_free()), decrementa il contatore e rilascia i riferimenti
+ * ai nomi internati dei giocatori.
  * 
  * @param game Puntatore alla partita da pulire
+ * @note Richiede il lock della partita (acquisisce lobby_lock e clients_lock)
  */
 void cleanup_game(game_session_t *game);
 
@@ -227,6 +536,11 @@ void handle_create_game(int client_fd);
 /**
  * Handler per MSG_LIST_GAMES - Lista partite disponibili
  * 
+ * Invia l'ultimo snapshot pubblicato della lista di attesa (lobby.h), già
+ * serializzato in ordine di creazione: nessun lock della lobby o delle
+ * partite e nessuna malloc. Oltre il limite di MAX_MESSAGE_SIZE la lista
+ * viene troncata alle partite più vecchie.
+ * 
  * @param client_fd File descriptor del client richiedente
  */
 void handle_list_games(int client_fd);
@@ -280,30 +594,30 @@ void handle_quit(int client_fd);
 /**
  * Invia notifica di cancellazione join al creatore originale
  * 
- * @param joiner_fd File descriptor del client che ha annullato la richiesta di join
- * @note Richiede che server_state.mutex sia già acquisito dal chiamante
+ * @param game Partita a cui era rivolta la richiesta di join
+ * @param joiner_name Nome del client che ha annullato la richiesta
+ * @note Richiede il lock della partita
  */
-void send_join_cancellation_notify_to_original_creator(int joiner_fd);
+void send_join_cancellation_notify_to_original_creator(game_session_t *game, const char *joiner_name);
 
 /**
  * Invia risposta di errore per LIST_GAMES
  * 
  * @param client_fd File descriptor del client
  * @param error Codice di errore da inviare
- * @note Richiede che server_state.mutex sia già acquisito dal chiamante
  */
 void send_list_games_error(int client_fd, error_code_t error);
 
 /**
- * Pulisce lo stato di un join pendente per un client
+ * Annulla la richiesta di join pendente su una partita
  * 
- * Se il client aveva richiesto di joinare una partita,
- * resetta lo stato della partita e del client.
+ * Svuota la richiesta nella partita e riporta il richiedente a
+ * CLIENT_REGISTERED.
  * 
- * @param client_fd File descriptor del client
- * @note Richiede che server_state.mutex sia già acquisito dal chiamante
+ * @param game Partita con la richiesta pendente
+ * @note Richiede il lock della partita (acquisisce clients_lock)
  */
-void cleanup_pending_join(int client_fd);
+void cleanup_pending_join(game_session_t *game);
 
 /**
  * Cleanup comune alla disconnessione di un client
@@ -324,6 +638,7 @@ void handle_disconnect(int client_fd);
  * 
  * Invia solo ai client con status CLIENT_REGISTERED (non in partita).
  * 
+ * @note Richiede che server_state.clients_lock sia già acquisito dal chiamante
  * @param msg_type Tipo di messaggio (es. MSG_NOTIFY)
  * @param payload Puntatore ai dati da inviare
  * @param payload_size Dimensione del payload in bytes
@@ -333,19 +648,19 @@ void broadcast_to_registered_clients(uint8_t msg_type, const void *payload, size
 /**
  * Notifica al creatore che qualcuno vuole joinare
  * 
- * @param creator_fd File descriptor del creatore della partita
+ * @param creator Connessione del creatore della partita
  * @param joiner_name Nome del giocatore che vuole joinare
  */
-void notify_join_request(int creator_fd, const char *joiner_name);
+void notify_join_request(conn_t creator, const char *joiner_name);
 
 /**
  * Notifica al joiner se è stato accettato o rifiutato
  * 
- * @param joiner_fd File descriptor del giocatore che ha richiesto join
+ * @param joiner Connessione del giocatore che ha richiesto join
  * @param game_id ID della partita
  * @param accepted 1 se accettato, 0 se rifiutato
  */
-void notify_join_response(int joiner_fd, const char *game_id, int accepted);
+void notify_join_response(conn_t joiner, const char *game_id, int accepted);
 
 /**
  * Notifica a entrambi i giocatori l'inizio della partita
@@ -353,6 +668,7 @@ void notify_join_response(int joiner_fd, const char *game_id, int accepted);
  * Invia NOTIFY_GAME_START con il simbolo assegnato e nome avversario.
  * 
  * @param game Puntatore alla partita che sta iniziando
+ * @note Richiede il lock della partita
  */
 void notify_game_start(game_session_t *game);
 
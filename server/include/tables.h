@@ -0,0 +1,104 @@
+#ifndef TABLES_H
+#define TABLES_H
+
+#include "server.h"
+
+// ============================================================================
+// TABELLE SEGMENTATE DI CLIENT E PARTITE
+// ============================================================================
+
+/*
+ * server_state.clients, clients_cold e games puntano a regioni riservate
+ * una volta sola per max_clients e max_games (solo indirizzi: la memoria
+ * viene impegnata quando la si usa). Le tabelle crescono e calano per
+ * segmenti di slot consecutivi, senza mai spostare un elemento: un
+ * puntatore a una partita resta valido finché si tiene il suo lock.
+ *
+ * Un segmento in coda rimasto vuoto viene ritirato (mai l'ultimo in uso, e
+ * solo se anche il precedente è vuoto, per non oscillare al confine) e le
+ * sue pagine tornano al sistema operativo. max_clients e max_games sono
+ * quindi solo il tetto di memoria, non la memoria occupata.
+ */
+
+// Slot per segmento: un segmento occupa pagine intere da 4 KB in ogni tabella
+// (client: 4 KB caldi e 16 KB freddi; partite: 4 KB)
+#define CLIENT_SEGMENT_SLOTS 256
+#define GAME_SEGMENT_SLOTS 64
+
+/**
+ * Riserva le regioni per server_state.max_clients e max_games
+ *
+ * Pubblica un segmento per tabella.
+ *
+ * @return 0 se successo, -1 se la riserva degli indirizzi fallisce
+ */
+int tables_init(void);
+
+/**
+ * Adatta la tabella dei client a 'count' client (dopo ogni aggiunta o rimozione)
+ *
+ * I client occupano sempre gli slot [0, count): la tabella cresce di un
+ * segmento quando count lo richiede e ne ritira uno quando restano
+ * almeno due segmenti interi liberi.
+ *
+ * @param count Numero di client (server_state.num_clients)
+ * @note Richiede che server_state.clients_lock sia già acquisito
+ */
+void clients_table_fit(int count);
+
+/**
+ * Preleva uno slot libero per una nuova partita
+ *
+ * Sceglie il segmento più basso con slot liberi (il più recente liberato
+ * al suo interno), così quelli in coda si svuotano quando il carico cala.
+ * Se tutti sono pieni pubblica un nuovo segmento.
+ *
+ * @return Slot (fuori dalla lista libera, non ancora attivo), o -1 se al tetto max_games
+ * @note Richiede che server_state.lobby_lock sia già acquisito
+ */
+int games_table_alloc(void);
+
+/**
+ * Rimette tra i liberi lo slot di una partita terminata
+ *
+ * Può ritirare i segmenti in coda rimasti vuoti; le loro pagine tornano
+ * al sistema operativo appena nessun thread può più avere in mano un
+ * indirizzo calcolato prima del ritiro (vedi lock_game_slot()).
+ *
+ * @param slot Slot da liberare (partita già marcata non attiva)
+ * @note Richiede che server_state.lobby_lock sia già acquisito
+ */
+void games_table_free(int slot);
+
+/**
+ * Slot di partite attualmente pubblicati
+ *
+ * @return Numero di slot utilizzabili (<= max_games)
+ */
+int games_table_capacity(void);
+
+/**
+ * Acquisisce il lock della partita nello slot indicato
+ *
+ * Unico modo per passare da un indice di partita (game_id, game_index di
+ * un client) al suo lock: l'indice può essere vecchio e il segmento
+ * ritirato nel frattempo. Il thread resta segnato come lettore delle
+ * partite fino a unlock_game(), e un segmento ritirato viene restituito
+ * al sistema solo quando tutti i lettori entrati prima del ritiro sono
+ * usciti. Il chiamante controlla poi active/generation come sempre.
+ *
+ * @param slot Slot in server_state.games
+ * @return Partita con il lock acquisito, o NULL se lo slot non è pubblicato
+ *         o se il record di lettura del thread non si può allocare
+ * @note Un thread tiene al più il lock di una partita alla volta
+ */
+game_session_t *lock_game_slot(int slot);
+
+/**
+ * Rilascia una partita ottenuta con lock_game_slot()
+ *
+ * @param game Partita con il lock acquisito
+ */
+void unlock_game(game_session_t *game);
+
+#endif
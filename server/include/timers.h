@@ -0,0 +1,82 @@
+#ifndef TIMERS_H
+#define TIMERS_H
+
+#include <stdbool.h>
+
+// ============================================================================
+// TIMER DELLE CONNESSIONI (TIMER WHEEL)
+// ============================================================================
+
+/**
+ * Scadenza sorvegliata per una connessione
+ *
+ * Una connessione ha al più un timer attivo: il tipo dipende da cosa
+ * resta nel suo decoder dopo l'ultima lettura.
+ */
+typedef enum {
+    TIMER_NONE = 0,     // Nessun timer attivo
+    TIMER_IDLE,         // Nessun messaggio a metà, client fuori dalle partite: connection_timeout
+    TIMER_HEADER,       // Header incompleto: read_timeout
+    TIMER_PAYLOAD       // Header completo, payload incompleto: read_timeout
+} conn_timer_kind_t;
+
+/**
+ * Inizializza la timer wheel
+ *
+ * Legge connection_timeout e read_timeout dalla configurazione (0 =
+ * scadenza disattivata). Se entrambi sono 0 le altre funzioni non fanno
+ * nulla. Da chiamare prima di outbound_init(), il cui thread di
+ * scrittura fa avanzare la ruota.
+ *
+ * @return 0 se successo, -1 se errore
+ */
+int timers_init(void);
+
+/**
+ * Arma (o riarma) il timer di una connessione
+ *
+ * O(1): il timer viene spostato nello slot della nuova scadenza. Il timer
+ * di inattività riparte a ogni chiamata; quelli di lettura (header e
+ * payload) no: se il tipo non cambia resta la scadenza già armata, così
+ * un client che invia un byte alla volta non la rinvia all'infinito.
+ *
+ * @param fd File descriptor del client
+ * @param kind Tipo di scadenza (TIMER_NONE equivale a timers_cancel())
+ */
+void timers_arm(int fd, conn_timer_kind_t kind);
+
+/**
+ * Accende o spegne il timer di inattività senza toccare quelli di lettura
+ *
+ * Per i cambi di stato decisi da altri thread (es. un client che entra in
+ * partita o ne esce): un header o un payload a metà resta sorvegliato
+ * dal proprio timer, e il timer di inattività già armato non riparte.
+ *
+ * @param fd File descriptor del client (connessione aperta)
+ * @param watch true per armare TIMER_IDLE se non c'è alcun timer, false
+ *              per disarmare un TIMER_IDLE
+ */
+void timers_watch_idle(int fd, bool watch);
+
+/**
+ * Disattiva il timer di una connessione
+ *
+ * O(1). Da chiamare prima di close(): dopo il ritorno la ruota non tocca
+ * più il file descriptor, che può quindi essere riutilizzato.
+ *
+ * @param fd File descriptor del client
+ */
+void timers_cancel(int fd);
+
+/**
+ * Fa avanzare la ruota fino all'istante corrente
+ *
+ * Le connessioni scadute vengono chiuse con shutdown(SHUT_RDWR): il
+ * percorso di lettura della modalità di I/O attiva vede EOF ed esegue
+ * handle_disconnect() e la normale rimozione del client.
+ *
+ * @return Millisecondi fino al prossimo tick, -1 se i timer sono disattivati
+ */
+int timers_expire(void);
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef URING_H
+#define URING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+// ============================================================================
+// MOTORE DI I/O IO_URING
+// ============================================================================
+
+/**
+ * Avvia il motore io_uring e gestisce le connessioni client
+ *
+ * Un unico thread possiede il ring: accept multishot sul socket server,
+ * recv multishot con buffer forniti dal kernel (buffer ring) per i client
+ * e invii header+payload come coppia di SQE collegate (IOSQE_IO_LINK).
+ * Sottomissioni e completamenti vengono raccolti in batch a ogni
+ * io_uring_enter().
+ *
+ * @param server_fd File descriptor del socket server
+ * @return -1 se il kernel non supporta le funzionalità richieste (il
+ *         chiamante deve usare un'altra modalità); altrimenti non ritorna
+ */
+int uring_run(int server_fd);
+
+/**
+ * Indica se il thread corrente è quello che possiede il ring
+ *
+ * @return true se gli invii devono passare da uring_send()
+ */
+bool uring_is_active(void);
+
+/**
+ * Accoda un messaggio (header + payload) per un client sul ring
+ *
+ * Il payload viene copiato: il chiamante può riutilizzare subito il
+ * proprio buffer. Gli invii verso lo stesso client restano ordinati.
+ * Da chiamare solo dal thread del ring (vedi uring_is_active()).
+ *
+ * @param client_fd File descriptor del client destinatario
+ * @param msg_type Tipo di messaggio (MSG_*)
+ * @param payload Puntatore al payload (NULL se nessun payload)
+ * @param payload_size Dimensione del payload in bytes
+ * @return Byte accodati (header + payload), -1 se errore
+ */
+ssize_t uring_send(int client_fd, uint8_t msg_type, const void *payload, size_t payload_size);
+
+#endif
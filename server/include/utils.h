@@ -8,20 +8,40 @@
 #include <pthread.h>
 #include "../../shared/include/logging.h"
 
+// Modalità di gestione dell'I/O dei client
+typedef enum {
+    IO_MODE_THREADS = 0,    // Un thread per ogni client (default)
+    IO_MODE_EPOLL = 1,      // Reactor epoll con pool fisso di thread
+    IO_MODE_URING = 2,      // Motore io_uring (fallback a threads se non supportato)
+    IO_MODE_POOL = 3,       // Reactor epoll per l'I/O, handler su pool di worker
+    IO_MODE_ACTORS = 4      // Reactor epoll per l'I/O, handler sullo shard della partita
+} IoMode;
+
 // Struttura per memorizzare la configurazione del server
 typedef struct {
     // Configurazioni di rete
     char server_ip[16];
     int port;
     int backlog_size;
+    char unix_socket[108];  // Listener AF_UNIX aggiuntivo ('@' = namespace astratto, vuoto = nessuno)
+    int tcp_fastopen;       // Coda TCP_FASTOPEN del listener (0 = disattivato)
+    int defer_accept;       // Secondi di TCP_DEFER_ACCEPT (0 = disattivato)
     
     // Limiti server
     int max_clients;
     int max_games;
     
-    // Timeout //NOTE: Non usati al momento
-    int connection_timeout;
-    int read_timeout;
+    // Modello di I/O
+    char io_mode[16];       // "threads", "epoll", "uring", "pool" o "actors"
+    int io_threads;         // Thread del reactor (0 = numero di core, 1 con pool e actors)
+    int worker_threads;     // Worker per gli handler con io_mode=pool (0 = numero di core)
+    int shards;             // Listener SO_REUSEPORT con io_mode=epoll (<= 1 = disattivato)
+    int actor_shards;       // Shard delle partite con io_mode=actors (0 = numero di core)
+    int max_send_queue;     // Messaggi in coda per client prima della disconnessione (0 = default)
+    
+    // Timeout in secondi (0 = disattivato), applicati dalla timer wheel
+    int connection_timeout; // Inattività: nessun messaggio a metà
+    int read_timeout;       // Completamento di un header o di un payload iniziato
     
     // Logging
     char log_level[20];
@@ -38,7 +58,17 @@ extern LogConfig log_config;
 int load_config(const char* config_file, ServerConfig* config);
 void print_config(const ServerConfig* config);
 
+// Converte la stringa io_mode della configurazione in enum
+IoMode get_io_mode_from_string(const char* mode_str);
+
 // Funzione per inizializzare la configurazione di logging dal server config
 void init_server_logging(void);
 
+// Conta un'allocazione fatta gestendo una richiesta (messaggi in uscita, snapshot
+// della lobby): a regime le cache sono calde e il contatore non cresce più
+void count_request_alloc(void);
+
+// Allocazioni contate finora da count_request_alloc()
+unsigned long get_request_allocs(void);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,40 @@
+#ifndef WORKERS_H
+#define WORKERS_H
+
+// ============================================================================
+// POOL DI WORKER CON WORK-STEALING
+// ============================================================================
+
+/**
+ * Funzione eseguita da un worker per ogni task
+ *
+ * @param task Task passato a workers_submit()
+ */
+typedef void (*worker_task_fn)(void *task);
+
+/**
+ * Avvia il pool di worker
+ *
+ * Ogni worker ha la propria deque di task: chi sottomette distribuisce i
+ * task a turno tra le deque, ogni worker preleva dalla testa della propria
+ * e, se è vuota, ruba dalla coda di quelle degli altri. Il pool non impone
+ * alcun ordine tra task diversi: l'ordine dei messaggi di uno stesso client
+ * è garantito dal chiamante, che non sottomette di nuovo una connessione
+ * finché il task precedente non è terminato.
+ *
+ * @param num_workers Numero di worker (<= 0 per usare il numero di core)
+ * @param fn Funzione eseguita per ogni task
+ * @return Numero di worker avviati, -1 se errore
+ */
+int workers_start(int num_workers, worker_task_fn fn);
+
+/**
+ * Accoda un task nella deque di uno dei worker
+ *
+ * Non blocca mai: può essere chiamata dai thread di I/O.
+ *
+ * @param task Task da eseguire (passato così com'è alla funzione del pool)
+ */
+void workers_submit(void *task);
+
+#endif
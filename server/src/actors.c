@@ -0,0 +1,188 @@
+#define _GNU_SOURCE // pthread_setaffinity_np
+#include "actors.h"
+#include "server.h"
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+
+// ============================================================================
+// STATO DEGLI SHARD
+// ============================================================================
+
+/**
+ * Shard: mailbox MPSC intrusiva (coda di Vyukov) e attesa del consumatore
+ *
+ * I produttori si contendono solo lo scambio atomico di 'head'; 'tail' è
+ * del solo shard. 'stub' tiene la coda mai vuota, così push e pop non
+ * devono gestire il caso della coda senza elementi.
+ */
+typedef struct {
+    // Righe separate: i push dei produttori non invalidano quella dello shard
+    actor_msg_t *head __attribute__((aligned(CACHE_LINE_SIZE))); // Ultimo accodato (produttori)
+    long pending;                       // Messaggi accodati e non ancora prelevati
+    actor_msg_t *tail __attribute__((aligned(CACHE_LINE_SIZE))); // Prossimo da prelevare (shard)
+    actor_msg_t stub;
+    pthread_mutex_t idle_lock;          // Solo per addormentare e svegliare lo shard
+    pthread_cond_t idle_cond;
+    int index;
+    int cpu;                            // Core su cui fissare il thread
+} shard_t;
+
+static shard_t *shards = NULL;
+static int num_shards = 0;
+static actor_msg_fn msg_fn = NULL;
+
+// ============================================================================
+// MAILBOX
+// ============================================================================
+
+static void mailbox_push(shard_t *shard, actor_msg_t *msg) {
+    __atomic_store_n(&msg->next, NULL, __ATOMIC_RELAXED);
+    actor_msg_t *prev = __atomic_exchange_n(&shard->head, msg, __ATOMIC_ACQ_REL);
+    // Fino a questa store il messaggio è accodato ma non ancora raggiungibile da 'tail'
+    __atomic_store_n(&prev->next, msg, __ATOMIC_RELEASE);
+}
+
+/**
+ * Preleva il messaggio più vecchio (solo dal thread dello shard)
+ *
+ * @return Messaggio, o NULL se la coda è vuota o un produttore è a metà push
+ */
+static actor_msg_t *mailbox_pop(shard_t *shard) {
+    actor_msg_t *tail = shard->tail;
+    actor_msg_t *next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+
+    if (tail == &shard->stub) {
+        if (!next) return NULL;
+        shard->tail = next;
+        tail = next;
+        next = __atomic_load_n(&next->next, __ATOMIC_ACQUIRE);
+    }
+    if (next) {
+        shard->tail = next;
+        return tail;
+    }
+
+    // 'tail' è l'ultimo collegato: lo si può consegnare solo rimettendo lo stub in coda
+    if (tail != __atomic_load_n(&shard->head, __ATOMIC_ACQUIRE)) {
+        return NULL;
+    }
+    mailbox_push(shard, &shard->stub);
+    next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+    if (next) {
+        shard->tail = next;
+        return tail;
+    }
+    return NULL;
+}
+
+// ============================================================================
+// THREAD DEGLI SHARD
+// ============================================================================
+
+static void *shard_thread(void *arg) {
+    shard_t *shard = arg;
+
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(shard->cpu, &cpuset);
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+    if (err != 0) {
+        LOG_WARN("Impossibile fissare lo shard %d sul core %d: %s",
+                 shard->index, shard->cpu, strerror(err));
+    }
+
+    while (1) {
+        actor_msg_t *msg = mailbox_pop(shard);
+        if (msg) {
+            __atomic_sub_fetch(&shard->pending, 1, __ATOMIC_SEQ_CST);
+            msg_fn(msg, shard->index);
+            continue;
+        }
+
+        if (__atomic_load_n(&shard->pending, __ATOMIC_SEQ_CST) > 0) {
+            // Un produttore ha scambiato 'head' ma non ha ancora collegato il messaggio
+            sched_yield();
+            continue;
+        }
+
+        // Mailbox vuota: attendi un actors_post()
+        pthread_mutex_lock(&shard->idle_lock);
+        while (__atomic_load_n(&shard->pending, __ATOMIC_SEQ_CST) <= 0) {
+            pthread_cond_wait(&shard->idle_cond, &shard->idle_lock);
+        }
+        pthread_mutex_unlock(&shard->idle_lock);
+    }
+
+    return NULL;
+}
+
+// ============================================================================
+// API PUBBLICA
+// ============================================================================
+
+int actors_start(int count, actor_msg_fn fn) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores <= 0) cores = 1;
+    if (count <= 0) {
+        count = (int)cores;
+    }
+
+    shards = aligned_alloc(CACHE_LINE_SIZE, count * sizeof(shard_t));
+    if (!shards) {
+        LOG_ERROR("Errore allocazione degli shard");
+        return -1;
+    }
+    memset(shards, 0, count * sizeof(shard_t));
+    for (int i = 0; i < count; i++) {
+        shards[i].head = &shards[i].stub;
+        shards[i].tail = &shards[i].stub;
+        shards[i].stub.next = NULL;
+        pthread_mutex_init(&shards[i].idle_lock, NULL);
+        pthread_cond_init(&shards[i].idle_cond, NULL);
+        shards[i].index = i;
+        shards[i].cpu = i % (int)cores;
+    }
+    num_shards = count;
+    msg_fn = fn;
+
+    for (int i = 0; i < count; i++) {
+        pthread_t tid;
+        if (pthread_create(&tid, NULL, shard_thread, &shards[i]) != 0) {
+            LOG_ERROR("Creazione shard %d fallita: %s", i, strerror(errno));
+            return -1;
+        }
+        pthread_detach(tid);
+    }
+
+    LOG_INFO("Avviati %d shard proprietari delle partite", count);
+    return count;
+}
+
+void actors_post(int shard_index, actor_msg_t *msg) {
+    shard_t *shard = &shards[shard_index];
+
+    // Contato prima di collegarlo: lo shard non dorme mai con un messaggio in arrivo
+    long previous = __atomic_fetch_add(&shard->pending, 1, __ATOMIC_SEQ_CST);
+    mailbox_push(shard, msg);
+
+    // Solo il passaggio da 0 a 1 può trovare lo shard addormentato
+    if (previous == 0) {
+        pthread_mutex_lock(&shard->idle_lock);
+        pthread_cond_signal(&shard->idle_cond);
+        pthread_mutex_unlock(&shard->idle_lock);
+    }
+}
+
+int actors_shard_of_game(int game_index) {
+    if (num_shards <= 0 || game_index < 0) return -1;
+    return game_index % num_shards;
+}
+
+int actors_home_shard(int fd) {
+    return (fd < 0 ? 0 : fd) % num_shards;
+}
@@ -0,0 +1,123 @@
+#include "lobby.h"
+#include "server.h"
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// STATO DEGLI SNAPSHOT
+// ============================================================================
+
+// Snapshot visibile ai lettori (scritto solo sotto lobby_lock, letto senza lock)
+static lobby_snapshot_t *current_snapshot = NULL;
+// Tutti i buffer allocati, correnti o riutilizzabili (protetto da lobby_lock)
+static lobby_snapshot_t *all_snapshots = NULL;
+static uint64_t last_version = 0;
+
+// ============================================================================
+// FUNZIONI DI SUPPORTO
+// ============================================================================
+
+/**
+ * Buffer in cui scrivere la prossima versione
+ *
+ * Non è mai quello corrente e nessun lettore lo tiene: un lettore che lo
+ * ha appena caricato se ne accorge ricontrollando il puntatore corrente
+ * in lobby_acquire() e non ne legge il contenuto.
+ *
+ * @note Richiede che server_state.lobby_lock sia già acquisito
+ */
+static lobby_snapshot_t *free_snapshot(void) {
+    lobby_snapshot_t *current = __atomic_load_n(&current_snapshot, __ATOMIC_RELAXED);
+    for (lobby_snapshot_t *s = all_snapshots; s; s = s->next) {
+        if (s != current && __atomic_load_n(&s->refs, __ATOMIC_SEQ_CST) == 0) {
+            return s;
+        }
+    }
+
+    lobby_snapshot_t *s = malloc(sizeof(lobby_snapshot_t));
+    if (!s) return NULL;
+    count_request_alloc();
+    s->refs = 0;
+    s->next = all_snapshots;
+    all_snapshots = s;
+    LOG_DEBUG("Lobby: nuovo buffer per gli snapshot (%zu byte)", sizeof(lobby_snapshot_t));
+    return s;
+}
+
+// ============================================================================
+// API PUBBLICA
+// ============================================================================
+
+int lobby_init(void) {
+    pthread_mutex_lock(&server_state.lobby_lock);
+    lobby_publish();
+    int ok = (current_snapshot != NULL);
+    pthread_mutex_unlock(&server_state.lobby_lock);
+
+    if (!ok) {
+        LOG_ERROR("Errore allocazione snapshot della lobby");
+        return -1;
+    }
+    return 0;
+}
+
+void lobby_publish(void) {
+    lobby_snapshot_t *snapshot = free_snapshot();
+    if (!snapshot) {
+        // I lettori continuano a vedere la versione precedente
+        LOG_ERROR("Errore allocazione snapshot della lobby, lista non aggiornata");
+        return;
+    }
+
+    int count = server_state.num_waiting;
+    if (count > MAX_LISTED_GAMES) count = MAX_LISTED_GAMES;
+
+    response_list_games_t *response = (response_list_games_t*)snapshot->data;
+    response->status = STATUS_OK;
+    response->error_code = ERR_NONE;
+    response->game_count = count;
+    response->reserved = 0;
+
+    // Generazione e creatore di una partita in lista non cambiano finché non ne esce
+    game_info_t *games_array = (game_info_t*)(snapshot->data + sizeof(response_list_games_t));
+    int idx = 0;
+    for (int i = server_state.waiting_head; i != -1 && idx < count;
+         i = server_state.games[i].wait_next) {
+        game_session_t *game = &server_state.games[i];
+
+        game_session_id(game, games_array[idx].game_id);
+
+        // La partita tiene un riferimento al creatore finché è in lista
+        strncpy(games_array[idx].creator, players_name(game->state.players[0]), MAX_PLAYER_NAME - 1);
+        games_array[idx].creator[MAX_PLAYER_NAME - 1] = '\0';
+
+        games_array[idx].status = GAME_WAITING;
+        games_array[idx].players_count = 1;  // Solo il creatore
+
+        idx++;
+    }
+
+    snapshot->waiting = server_state.num_waiting;
+    snapshot->size = sizeof(response_list_games_t) + (size_t)count * sizeof(game_info_t);
+    snapshot->version = ++last_version;
+
+    // Da qui i nuovi lettori vedono la versione completa
+    __atomic_store_n(&current_snapshot, snapshot, __ATOMIC_SEQ_CST);
+}
+
+const lobby_snapshot_t *lobby_acquire(void) {
+    for (;;) {
+        lobby_snapshot_t *snapshot = __atomic_load_n(&current_snapshot, __ATOMIC_SEQ_CST);
+        __atomic_add_fetch(&snapshot->refs, 1, __ATOMIC_SEQ_CST);
+
+        // Ancora corrente dopo aver preso il riferimento: nessuno lo riscriverà
+        if (__atomic_load_n(&current_snapshot, __ATOMIC_SEQ_CST) == snapshot) {
+            return snapshot;
+        }
+        __atomic_sub_fetch(&snapshot->refs, 1, __ATOMIC_SEQ_CST);
+    }
+}
+
+void lobby_release(const lobby_snapshot_t *snapshot) {
+    __atomic_sub_fetch(&((lobby_snapshot_t*)snapshot)->refs, 1, __ATOMIC_RELEASE);
+}
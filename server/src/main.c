@@ -3,6 +3,10 @@
 #include <unistd.h>
 #include "../include/utils.h"
 #include "server.h"
+#include "reactor.h"
+#include "uring.h"
+#include "outbound.h"
+#include "timers.h"
 
 int main() {
     // Carica la configurazione
@@ -24,8 +28,49 @@ int main() {
         exit(EXIT_FAILURE);
     }
 
-    // Avvia il server (loop principale)
-    start_server(server_fd);
+    // Listener AF_UNIX opzionale per i processi locali (stesso protocollo e handler)
+    if (server_config.unix_socket[0] != '\0') {
+        server_state.unix_fd = init_unix_server(server_config.unix_socket);
+        if (server_state.unix_fd < 0) {
+            LOG_ERROR("Inizializzazione socket unix fallita");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // Timer wheel per connection_timeout e read_timeout (avanzata dal thread di scrittura)
+    if (timers_init() < 0) {
+        LOG_ERROR("Inizializzazione timer delle connessioni fallita");
+        exit(EXIT_FAILURE);
+    }
+
+    // Code di uscita per client: nessun invio sotto i lock dello stato,
+    // rifiuto delle connessioni in eccesso senza bloccare l'acceptor
+    if (outbound_init() < 0) {
+        LOG_ERROR("Inizializzazione code di uscita fallita");
+        exit(EXIT_FAILURE);
+    }
+
+    // Avvia il server (loop principale) nella modalità di I/O configurata
+    IoMode io_mode = get_io_mode_from_string(server_config.io_mode);
+    
+    if (io_mode == IO_MODE_URING && uring_run(server_fd) < 0) {
+        // Kernel senza io_uring (o senza buffer ring): torna al modello classico
+        LOG_WARN("io_uring non supportato, fallback a io_mode=threads");
+        printf("ATTENZIONE: io_uring non supportato, utilizzo io_mode=threads\n");
+        io_mode = IO_MODE_THREADS;
+    }
+    
+    if (io_mode == IO_MODE_EPOLL && server_config.shards > 1) {
+        reactor_run_shards(server_fd, server_config.shards);
+    } else if (io_mode == IO_MODE_EPOLL) {
+        reactor_run(server_fd, server_config.io_threads);
+    } else if (io_mode == IO_MODE_POOL) {
+        reactor_run_pool(server_fd, server_config.io_threads, server_config.worker_threads);
+    } else if (io_mode == IO_MODE_ACTORS) {
+        reactor_run_actors(server_fd, server_config.io_threads, server_config.actor_shards);
+    } else {
+        start_server(server_fd);
+    }
 
     // Questo punto non dovrebbe mai essere raggiunto
     close(server_fd);
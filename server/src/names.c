@@ -0,0 +1,212 @@
+#include "names.h"
+#include "server.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Dimensione iniziale (potenza di 2) e slot migrati per operazione durante la crescita
+#define NAMES_INITIAL_CAPACITY 64
+#define NAMES_MIGRATE_STEP 16
+
+// Valori speciali del campo fd
+#define NAME_EMPTY -1
+#define NAME_TOMBSTONE -2                // Solo nella vecchia tabella durante la migrazione
+
+// ============================================================================
+// STATO DELL'INDICE
+// ============================================================================
+
+typedef struct {
+    uint32_t hash;
+    int fd;                             // NAME_EMPTY, NAME_TOMBSTONE o fd del client
+} name_entry_t;
+
+typedef struct {
+    name_entry_t *entries;
+    size_t capacity;                    // Potenza di 2
+} name_table_t;
+
+static name_table_t table;              // Tabella corrente: riceve tutti gli inserimenti
+static name_table_t old_table;          // Tabella in migrazione (entries NULL se nessuna)
+static size_t migrate_pos;              // Primo slot di old_table non ancora migrato
+static size_t name_count;               // Nomi totali (in entrambe le tabelle)
+
+// ============================================================================
+// FUNZIONI DI SUPPORTO
+// ============================================================================
+
+// FNV-1a sul nome (al più MAX_PLAYER_NAME byte)
+static uint32_t name_hash(const char *name) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < MAX_PLAYER_NAME && name[i] != '\0'; i++) {
+        hash ^= (uint8_t)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int table_alloc(name_table_t *t, size_t capacity) {
+    t->entries = malloc(capacity * sizeof(name_entry_t));
+    if (!t->entries) return -1;
+    t->capacity = capacity;
+    for (size_t i = 0; i < capacity; i++) {
+        t->entries[i].fd = NAME_EMPTY;
+    }
+    return 0;
+}
+
+// Confronta con il nome del client registrato sul fd dell'elemento
+static int entry_matches(const name_entry_t *e, uint32_t hash, const char *name) {
+    if (e->hash != hash) return -1;
+    int idx = find_client_by_fd(e->fd);
+    if (idx == -1 || strncmp(server_state.clients_cold[idx].name, name, MAX_PLAYER_NAME) != 0) {
+        return -1;
+    }
+    return idx;
+}
+
+/**
+ * Posizione dell'elemento con il fd dato (o del nome dato se fd < 0)
+ *
+ * I tombstone della vecchia tabella non interrompono la sequenza di probing.
+ */
+static long table_lookup(const name_table_t *t, uint32_t hash, const char *name, int fd) {
+    size_t mask = t->capacity - 1;
+    for (size_t i = 0; i < t->capacity; i++) {
+        size_t pos = (hash + i) & mask;
+        const name_entry_t *e = &t->entries[pos];
+        if (e->fd == NAME_EMPTY) return -1;
+        if (e->fd == NAME_TOMBSTONE) continue;
+        if (fd >= 0 ? (e->fd == fd) : (entry_matches(e, hash, name) != -1)) {
+            return (long)pos;
+        }
+    }
+    return -1;
+}
+
+static void table_put(name_table_t *t, uint32_t hash, int fd) {
+    size_t mask = t->capacity - 1;
+    size_t pos = hash & mask;
+    while (t->entries[pos].fd != NAME_EMPTY) {
+        pos = (pos + 1) & mask;
+    }
+    t->entries[pos].hash = hash;
+    t->entries[pos].fd = fd;
+}
+
+// Cancellazione con backward shift: la tabella corrente non ha mai tombstone
+static void table_delete(name_table_t *t, size_t pos) {
+    size_t mask = t->capacity - 1;
+    size_t hole = pos;
+    size_t next = pos;
+    for (;;) {
+        next = (next + 1) & mask;
+        if (t->entries[next].fd == NAME_EMPTY) break;
+        size_t home = t->entries[next].hash & mask;
+        // L'elemento può riempire il buco se la sua posizione ideale non cade in (hole, next]
+        int movable = (hole <= next) ? (home <= hole || home > next)
+                                     : (home <= hole && home > next);
+        if (movable) {
+            t->entries[hole] = t->entries[next];
+            hole = next;
+        }
+    }
+    t->entries[hole].fd = NAME_EMPTY;
+}
+
+// Sposta al più 'steps' slot dalla vecchia tabella a quella corrente
+static void migrate(size_t steps) {
+    if (!old_table.entries) return;
+
+    for (size_t i = 0; i < steps && migrate_pos < old_table.capacity; i++, migrate_pos++) {
+        name_entry_t *e = &old_table.entries[migrate_pos];
+        if (e->fd >= 0) {
+            table_put(&table, e->hash, e->fd);
+            e->fd = NAME_TOMBSTONE;
+        }
+    }
+
+    if (migrate_pos == old_table.capacity) {
+        LOG_DEBUG("Indice dei nomi: migrazione a %zu slot completata", table.capacity);
+        free(old_table.entries);
+        old_table.entries = NULL;
+        old_table.capacity = 0;
+    }
+}
+
+// Avvia la crescita se l'inserimento porterebbe il carico oltre 3/4
+static int grow_if_needed(void) {
+    if ((name_count + 1) * 4 <= table.capacity * 3) return 0;
+
+    // Caso limite: migrazione precedente non ancora finita
+    migrate(SIZE_MAX);
+
+    name_table_t bigger;
+    if (table_alloc(&bigger, table.capacity * 2) < 0) {
+        LOG_ERROR("Errore allocazione indice dei nomi (%zu slot)", table.capacity * 2);
+        return -1;
+    }
+    old_table = table;
+    table = bigger;
+    migrate_pos = 0;
+    LOG_DEBUG("Indice dei nomi: crescita a %zu slot (%zu nomi)", table.capacity, name_count);
+    return 0;
+}
+
+// ============================================================================
+// API PUBBLICA
+// ============================================================================
+
+int names_init(void) {
+    if (table_alloc(&table, NAMES_INITIAL_CAPACITY) < 0) {
+        LOG_ERROR("Errore allocazione indice dei nomi");
+        return -1;
+    }
+    old_table.entries = NULL;
+    old_table.capacity = 0;
+    name_count = 0;
+    return 0;
+}
+
+int names_find(const char *name) {
+    if (!name) return -1;
+    uint32_t hash = name_hash(name);
+
+    long pos = table_lookup(&table, hash, name, -1);
+    if (pos != -1) return find_client_by_fd(table.entries[pos].fd);
+
+    if (old_table.entries) {
+        pos = table_lookup(&old_table, hash, name, -1);
+        if (pos != -1) return find_client_by_fd(old_table.entries[pos].fd);
+    }
+    return -1;
+}
+
+int names_insert(const char *name, int fd) {
+    if (grow_if_needed() < 0) return -1;
+    migrate(NAMES_MIGRATE_STEP);
+
+    table_put(&table, name_hash(name), fd);
+    name_count++;
+    return 0;
+}
+
+void names_remove(const char *name, int fd) {
+    uint32_t hash = name_hash(name);
+
+    long pos = table_lookup(&table, hash, name, fd);
+    if (pos != -1) {
+        table_delete(&table, (size_t)pos);
+        name_count--;
+    } else if (old_table.entries &&
+               (pos = table_lookup(&old_table, hash, name, fd)) != -1) {
+        // Niente backward shift nella vecchia tabella: sposterebbe elementi non ancora
+        // migrati in slot che la migrazione ha già superato
+        old_table.entries[pos].fd = NAME_TOMBSTONE;
+        name_count--;
+    } else {
+        LOG_WARN("Nome '%s' (FD=%d) non presente nell'indice", name, fd);
+    }
+
+    migrate(NAMES_MIGRATE_STEP);
+}
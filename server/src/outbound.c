@@ -0,0 +1,729 @@
+#include "outbound.h"
+#include "server.h"
+#include "timers.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+// Limite alla tabella indicizzata per fd se RLIMIT_NOFILE è illimitato
+#define OUTBOUND_MAX_FDS (1 << 20)
+// Messaggi scritti al più con una singola sendmsg()
+#define OUTBOUND_IOV_MAX 64
+#define MAX_WRITER_EVENTS 64
+// Attesa massima della chiusura da parte di un client rifiutato
+#define OUTBOUND_LINGER_MS 500
+// Classi dei messaggi in uscita: risposte e notifiche, messaggi fino a MAX_MESSAGE_SIZE
+#define FRAME_SMALL_SIZE 256
+#define FRAME_LARGE_SIZE (sizeof(protocol_header_t) + MAX_MESSAGE_SIZE)
+// Messaggi liberi tenuti per thread in ciascuna classe
+#define FRAME_CACHE_SMALL 64
+#define FRAME_CACHE_LARGE 4
+// Messaggi liberi tenuti nel deposito condiviso (~1 MB per classe)
+#define FRAME_DEPOT_SMALL 4096
+#define FRAME_DEPOT_LARGE 256
+
+// ============================================================================
+// STATO DELLE CODE
+// ============================================================================
+
+/**
+ * Messaggio in coda: header (già in network byte order) e payload contigui
+ */
+typedef struct out_frame {
+    struct out_frame *next;
+    size_t capacity;                    // FRAME_SMALL_SIZE o FRAME_LARGE_SIZE
+    size_t length;                      // Byte totali (header + payload)
+    size_t sent;                        // Byte già scritti sul socket
+    uint8_t data[];
+} out_frame_t;
+
+/**
+ * Connessione rifiutata in attesa di chiusura (lista FIFO: timeout costante)
+ */
+typedef struct linger_entry {
+    struct linger_entry *next;
+    struct outbound *out;
+    uint64_t deadline_ms;               // Chiusura forzata allo scadere
+    bool done;                          // Già chiusa (dal client o per errore)
+} linger_entry_t;
+
+/**
+ * Coda di uscita di una connessione
+ *
+ * Protetta dal proprio lock, mai dai lock dello stato del server: le scritture sul
+ * socket avvengono solo tenendo questo lock e sempre con MSG_DONTWAIT.
+ */
+typedef struct outbound {
+    pthread_mutex_t lock;
+    int fd;
+    bool open;                          // Connessione attiva
+    bool overflowed;                    // Client troppo lento: invii scartati
+    bool in_pending;                    // In attesa nella lista di un thread
+    bool writer_armed;                  // Affidata al thread di scrittura (EPOLLOUT)
+    out_frame_t *head;
+    out_frame_t *tail;
+    size_t depth;                       // Messaggi in coda
+    struct outbound *next_pending;      // Lista del thread che deve svuotarla
+    linger_entry_t *linger;             // Connessione rifiutata: chiusura differita
+    bool wr_shutdown;                   // shutdown(SHUT_WR) già eseguito
+} outbound_t;
+
+// Tabella indicizzata per fd: gli elementi non vengono mai liberati, così
+// un lookup concorrente con una chiusura non accede a memoria rilasciata
+static outbound_t **outbound_table = NULL;
+static size_t outbound_table_size = 0;
+static pthread_mutex_t outbound_table_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static size_t outbound_max_frames = OUTBOUND_DEFAULT_MAX_FRAMES;
+static int writer_epoll_fd = -1;
+static int writer_wake_fd = -1;         // eventfd: nuovo timer di chiusura da armare
+
+// Connessioni rifiutate in attesa di chiusura, gestite solo dal thread di scrittura
+static linger_entry_t *linger_head = NULL;
+static linger_entry_t *linger_tail = NULL;
+static pthread_mutex_t linger_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Contatori delle connessioni rifiutate
+static unsigned long rejected_total = 0;
+static unsigned long rejected_lingering = 0;
+static unsigned long rejected_timeouts = 0;
+
+// Code segnate dal thread corrente e non ancora svuotate
+static __thread outbound_t *pending_head = NULL;
+
+/**
+ * Messaggi liberi del thread corrente, per classe (0 = piccoli, 1 = grandi)
+ *
+ * Un messaggio viene di solito liberato dal thread che l'ha creato
+ * (outbound_flush_pending() subito dopo l'handler). Quando non succede,
+ * ad esempio per i broadcast, un thread accumula messaggi liberi e un
+ * altro li esaurisce: le eccedenze passano a blocchi nel deposito
+ * condiviso, da cui chi resta senza li riprende prima di allocare.
+ */
+static __thread out_frame_t *frame_cache[2];
+static __thread unsigned int frame_cache_count[2];
+static pthread_key_t frame_cache_key;
+static pthread_once_t frame_cache_once = PTHREAD_ONCE_INIT;
+
+// Deposito condiviso dei messaggi liberi (solo per i passaggi tra thread)
+static out_frame_t *frame_depot[2];
+static unsigned int frame_depot_count[2];
+static pthread_mutex_t frame_depot_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// ============================================================================
+// FUNZIONI DI SUPPORTO
+// ============================================================================
+
+static outbound_t *outbound_lookup(int fd) {
+    if (fd < 0 || (size_t)fd >= outbound_table_size) return NULL;
+    return __atomic_load_n(&outbound_table[fd], __ATOMIC_ACQUIRE);
+}
+
+static unsigned int frame_cache_limit(int cls) {
+    return cls ? FRAME_CACHE_LARGE : FRAME_CACHE_SMALL;
+}
+
+/**
+ * Sposta nel deposito al più 'count' messaggi della cache del thread
+ *
+ * Oltre FRAME_DEPOT_SMALL/FRAME_DEPOT_LARGE messaggi il deposito non
+ * cresce: il resto torna all'allocatore.
+ */
+static void frame_cache_drain(int cls, unsigned int count) {
+    unsigned int depot_max = cls ? FRAME_DEPOT_LARGE : FRAME_DEPOT_SMALL;
+
+    pthread_mutex_lock(&frame_depot_lock);
+    while (count-- > 0 && frame_cache[cls]) {
+        out_frame_t *frame = frame_cache[cls];
+        frame_cache[cls] = frame->next;
+        frame_cache_count[cls]--;
+        if (frame_depot_count[cls] < depot_max) {
+            frame->next = frame_depot[cls];
+            frame_depot[cls] = frame;
+            frame_depot_count[cls]++;
+        } else {
+            free(frame);
+        }
+    }
+    pthread_mutex_unlock(&frame_depot_lock);
+}
+
+// Alla fine di un thread (es. io_mode=threads) la sua cache torna al deposito
+static void frame_cache_destroy(void *arg) {
+    (void)arg;
+    for (int cls = 0; cls < 2; cls++) {
+        frame_cache_drain(cls, frame_cache_count[cls]);
+    }
+}
+
+static void frame_cache_key_init(void) {
+    pthread_key_create(&frame_cache_key, frame_cache_destroy);
+}
+
+// Da chiamare quando la cache del thread passa da vuota a non vuota
+static void frame_cache_register(void) {
+    if (!frame_cache[0] && !frame_cache[1]) {
+        pthread_once(&frame_cache_once, frame_cache_key_init);
+        pthread_setspecific(frame_cache_key, frame_cache);
+    }
+}
+
+static out_frame_t *frame_alloc(size_t length) {
+    int cls = (length <= FRAME_SMALL_SIZE) ? 0 : 1;
+
+    // Cache vuota (raro a regime): riprendi dal deposito un piccolo blocco in un colpo solo,
+    // senza svuotarlo per i thread di breve vita (es. io_mode=threads)
+    if (!frame_cache[cls]) {
+        frame_cache_register();
+        pthread_mutex_lock(&frame_depot_lock);
+        unsigned int refill = frame_cache_limit(cls) / 8 + 1;
+        while (refill-- > 0 && frame_depot[cls]) {
+            out_frame_t *frame = frame_depot[cls];
+            frame_depot[cls] = frame->next;
+            frame_depot_count[cls]--;
+            frame->next = frame_cache[cls];
+            frame_cache[cls] = frame;
+            frame_cache_count[cls]++;
+        }
+        pthread_mutex_unlock(&frame_depot_lock);
+    }
+
+    out_frame_t *frame = frame_cache[cls];
+    if (frame) {
+        frame_cache[cls] = frame->next;
+        frame_cache_count[cls]--;
+        return frame;
+    }
+
+    size_t capacity = cls ? FRAME_LARGE_SIZE : FRAME_SMALL_SIZE;
+    frame = malloc(sizeof(out_frame_t) + capacity);
+    if (frame) {
+        frame->capacity = capacity;
+        count_request_alloc();
+    }
+    return frame;
+}
+
+static void frame_free(out_frame_t *frame) {
+    int cls = (frame->capacity > FRAME_SMALL_SIZE) ? 1 : 0;
+
+    frame_cache_register();
+    frame->next = frame_cache[cls];
+    frame_cache[cls] = frame;
+    frame_cache_count[cls]++;
+
+    // Cache piena: metà passa al deposito per i thread che allocano più di quanto liberano
+    if (frame_cache_count[cls] > frame_cache_limit(cls)) {
+        frame_cache_drain(cls, frame_cache_limit(cls) / 2);
+    }
+}
+
+static void free_frames(out_frame_t *frame) {
+    while (frame) {
+        out_frame_t *next = frame->next;
+        frame_free(frame);
+        frame = next;
+    }
+}
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * Copia i messaggi (header in network byte order + payload) in una lista
+ *
+ * @return Byte totali, -1 se errore di allocazione
+ */
+static ssize_t build_frames(int client_fd, const protocol_frame_t *frames, size_t count,
+                            out_frame_t **first_out, out_frame_t **last_out) {
+    out_frame_t *first = NULL, *last = NULL;
+    ssize_t total = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        size_t payload_size = frames[i].payload ? frames[i].payload_size : 0;
+        size_t length = sizeof(protocol_header_t) + payload_size;
+
+        out_frame_t *frame = frame_alloc(length);
+        if (!frame) {
+            LOG_ERROR("Errore allocazione messaggio in uscita per FD=%d", client_fd);
+            free_frames(first);
+            return -1;
+        }
+        frame->next = NULL;
+        frame->length = length;
+        frame->sent = 0;
+
+        protocol_header_t header;
+        protocol_init_header(&header, frames[i].msg_type, (uint16_t)payload_size, frames[i].seq_id);
+        memcpy(frame->data, &header, sizeof(header));
+        if (payload_size > 0) {
+            memcpy(frame->data + sizeof(header), frames[i].payload, payload_size);
+        }
+
+        if (last) last->next = frame; else first = frame;
+        last = frame;
+        total += length;
+    }
+
+    *first_out = first;
+    *last_out = last;
+    return total;
+}
+
+/**
+ * Affida una coda con dati residui al thread di scrittura
+ *
+ * Il registro epoll resta anche dopo EPOLLONESHOT: si prova prima MOD,
+ * poi ADD se il fd non è (più) registrato. Per una connessione rifiutata
+ * si attende anche EPOLLIN, per accorgersi della chiusura del client.
+ * @note Richiede che out->lock sia già acquisito
+ */
+static void writer_arm(outbound_t *out) {
+    struct epoll_event ev;
+    ev.events = EPOLLONESHOT | (out->head ? EPOLLOUT : 0);
+    if (out->linger) {
+        ev.events |= EPOLLIN | EPOLLRDHUP; // Attende anche la chiusura del client
+    }
+    ev.data.fd = out->fd;
+
+    if (epoll_ctl(writer_epoll_fd, EPOLL_CTL_MOD, out->fd, &ev) < 0 &&
+        (errno != ENOENT || epoll_ctl(writer_epoll_fd, EPOLL_CTL_ADD, out->fd, &ev) < 0)) {
+        LOG_ERROR("Impossibile attendere EPOLLOUT per FD=%d: %s", out->fd, strerror(errno));
+        return;
+    }
+    out->writer_armed = true;
+}
+
+/**
+ * Scrive sul socket tutto ciò che accetta senza bloccare
+ *
+ * Se il socket è pieno la coda passa al thread di scrittura; in caso di
+ * errore i messaggi vengono scartati e la disconnessione è lasciata al
+ * percorso di lettura.
+ * @note Richiede che out->lock sia già acquisito
+ */
+static void outbound_write(outbound_t *out) {
+    while (out->open && !out->overflowed && out->head) {
+        struct iovec iov[OUTBOUND_IOV_MAX];
+        int iovcnt = 0;
+        for (out_frame_t *f = out->head; f && iovcnt < OUTBOUND_IOV_MAX; f = f->next) {
+            iov[iovcnt].iov_base = f->data + f->sent;
+            iov[iovcnt].iov_len = f->length - f->sent;
+            iovcnt++;
+        }
+
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iovcnt;
+
+        ssize_t sent = sendmsg(out->fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                writer_arm(out);
+                return;
+            }
+            LOG_WARN("Errore invio a FD=%d: %s", out->fd, strerror(errno));
+            free_frames(out->head);
+            out->head = out->tail = NULL;
+            out->depth = 0;
+            return;
+        }
+
+        // Rimuovi i messaggi completamente inviati e avanza in quello parziale
+        size_t remaining = (size_t)sent;
+        while (out->head && remaining >= out->head->length - out->head->sent) {
+            out_frame_t *done = out->head;
+            remaining -= done->length - done->sent;
+            out->head = done->next;
+            out->depth--;
+            frame_free(done);
+        }
+        if (!out->head) {
+            out->tail = NULL;
+        } else {
+            out->head->sent += remaining;
+        }
+    }
+
+    // Connessione rifiutata: inviato tutto, il client vedrà EOF dopo la risposta
+    if (out->linger && !out->head && !out->wr_shutdown) {
+        shutdown(out->fd, SHUT_WR);
+        out->wr_shutdown = true;
+    }
+}
+
+// ============================================================================
+// CHIUSURA DIFFERITA DELLE CONNESSIONI RIFIUTATE
+// ============================================================================
+
+/**
+ * Chiude definitivamente una connessione rifiutata
+ * @note Richiede che out->lock sia già acquisito
+ */
+static void linger_finish(outbound_t *out) {
+    out->linger->done = true;
+    out->linger = NULL;
+    out->open = false;
+    out->writer_armed = false;
+    free_frames(out->head);
+    out->head = out->tail = NULL;
+    out->depth = 0;
+    close(out->fd);
+    __atomic_sub_fetch(&rejected_lingering, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * Scarta i byte inviati da un client rifiutato
+ *
+ * @return true se il client ha chiuso la connessione (o errore)
+ */
+static bool linger_drain(outbound_t *out) {
+    uint8_t discard[512];
+    while (1) {
+        ssize_t n = recv(out->fd, discard, sizeof(discard), MSG_DONTWAIT);
+        if (n > 0) continue;
+        if (n < 0 && errno == EINTR) continue;
+        return !(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+    }
+}
+
+/**
+ * Chiude le connessioni rifiutate il cui timer è scaduto
+ *
+ * @return Millisecondi fino alla prossima scadenza, -1 se nessuna
+ */
+static int linger_expire(void) {
+    uint64_t now = now_ms();
+    linger_entry_t *expired = NULL;
+    int timeout = -1;
+
+    pthread_mutex_lock(&linger_lock);
+    while (linger_head && linger_head->deadline_ms <= now) {
+        linger_entry_t *entry = linger_head;
+        linger_head = entry->next;
+        entry->next = expired;
+        expired = entry;
+    }
+    if (!linger_head) {
+        linger_tail = NULL;
+    } else {
+        timeout = (int)(linger_head->deadline_ms - now);
+    }
+    pthread_mutex_unlock(&linger_lock);
+
+    while (expired) {
+        linger_entry_t *entry = expired;
+        expired = entry->next;
+
+        outbound_t *out = entry->out;
+        pthread_mutex_lock(&out->lock);
+        if (!entry->done) {
+            LOG_DEBUG("Timer di chiusura scaduto per connessione rifiutata FD=%d", out->fd);
+            __atomic_add_fetch(&rejected_timeouts, 1, __ATOMIC_RELAXED);
+            linger_finish(out);
+        }
+        pthread_mutex_unlock(&out->lock);
+        free(entry);
+    }
+
+    return timeout;
+}
+
+/**
+ * Thread di scrittura: completa gli invii dei socket tornati scrivibili
+ */
+static void *writer_thread(void *arg) {
+    (void)arg;
+    struct epoll_event events[MAX_WRITER_EVENTS];
+    int timeout = timers_expire(); // Con i timer attivi la ruota avanza a ogni tick
+
+    while (1) {
+        int n = epoll_wait(writer_epoll_fd, events, MAX_WRITER_EVENTS, timeout);
+        if (n < 0) {
+            if (errno != EINTR) {
+                LOG_ERROR("epoll_wait del writer fallito: %s", strerror(errno));
+            }
+            n = 0;
+        }
+
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.fd == writer_wake_fd) {
+                uint64_t value;
+                if (read(writer_wake_fd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+                    LOG_WARN("Lettura eventfd del writer fallita: %s", strerror(errno));
+                }
+                continue;
+            }
+
+            outbound_t *out = outbound_lookup(events[i].data.fd);
+            if (!out) continue;
+
+            pthread_mutex_lock(&out->lock);
+            out->writer_armed = false;
+            if (out->linger) {
+                if ((events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) &&
+                    linger_drain(out)) {
+                    linger_finish(out); // Il client ha chiuso: niente attesa
+                } else {
+                    outbound_write(out);
+                    if (out->linger && !out->writer_armed) {
+                        writer_arm(out);
+                    }
+                }
+            } else if (out->open) {
+                outbound_write(out);
+            }
+            pthread_mutex_unlock(&out->lock);
+        }
+
+        // Stesso loop per i rifiuti in chiusura e per la timer wheel delle connessioni
+        timeout = linger_expire();
+        int wheel_timeout = timers_expire();
+        if (wheel_timeout >= 0 && (timeout < 0 || wheel_timeout < timeout)) {
+            timeout = wheel_timeout;
+        }
+    }
+    return NULL;
+}
+
+// ============================================================================
+// API PUBBLICA
+// ============================================================================
+
+int outbound_init(void) {
+    struct rlimit limit;
+    size_t size = OUTBOUND_MAX_FDS;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY &&
+        limit.rlim_cur < OUTBOUND_MAX_FDS) {
+        size = limit.rlim_cur;
+    }
+
+    outbound_table = calloc(size, sizeof(outbound_t *));
+    if (!outbound_table) {
+        LOG_ERROR("Errore allocazione tabella code di uscita (%zu fd)", size);
+        return -1;
+    }
+    outbound_table_size = size;
+
+    if (server_config.max_send_queue > 0) {
+        outbound_max_frames = server_config.max_send_queue;
+    }
+
+    writer_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (writer_epoll_fd < 0) {
+        LOG_ERROR("epoll_create1 del writer fallito: %s", strerror(errno));
+        return -1;
+    }
+
+    writer_wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.fd = writer_wake_fd;
+    if (writer_wake_fd < 0 || epoll_ctl(writer_epoll_fd, EPOLL_CTL_ADD, writer_wake_fd, &ev) < 0) {
+        LOG_ERROR("eventfd del writer non disponibile: %s", strerror(errno));
+        return -1;
+    }
+
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, writer_thread, NULL) != 0) {
+        LOG_ERROR("Errore creazione thread di scrittura");
+        return -1;
+    }
+    pthread_detach(tid);
+
+    LOG_INFO("Code di uscita inizializzate (max %zu messaggi per client)", outbound_max_frames);
+    return 0;
+}
+
+void outbound_open(int client_fd) {
+    if (client_fd < 0 || (size_t)client_fd >= outbound_table_size) {
+        LOG_ERROR("FD=%d oltre la tabella delle code di uscita", client_fd);
+        return;
+    }
+
+    outbound_t *out = outbound_lookup(client_fd);
+    if (!out) {
+        pthread_mutex_lock(&outbound_table_mutex);
+        out = outbound_table[client_fd];
+        if (!out) {
+            out = calloc(1, sizeof(outbound_t));
+            if (!out) {
+                pthread_mutex_unlock(&outbound_table_mutex);
+                LOG_ERROR("Errore allocazione coda di uscita per FD=%d", client_fd);
+                return;
+            }
+            pthread_mutex_init(&out->lock, NULL);
+            out->fd = client_fd;
+            __atomic_store_n(&outbound_table[client_fd], out, __ATOMIC_RELEASE);
+        }
+        pthread_mutex_unlock(&outbound_table_mutex);
+    }
+
+    pthread_mutex_lock(&out->lock);
+    out->open = true;
+    out->overflowed = false;
+    out->wr_shutdown = false;
+    pthread_mutex_unlock(&out->lock);
+}
+
+void outbound_close(int client_fd) {
+    outbound_t *out = outbound_lookup(client_fd);
+    if (!out) return;
+
+    pthread_mutex_lock(&out->lock);
+    out->open = false;
+    out->writer_armed = false; // close() rimuove il fd dall'epoll del writer
+    free_frames(out->head);
+    out->head = out->tail = NULL;
+    out->depth = 0;
+    pthread_mutex_unlock(&out->lock);
+}
+
+/**
+ * Accoda i messaggi nella coda di un fd (vedi outbound_enqueue())
+ *
+ * Con conn diverso da CONN_NONE la connessione viene verificata sotto il
+ * lock della coda: remove_client() avanza la generazione prima di
+ * outbound_close(), che prende lo stesso lock, quindi i messaggi accodati
+ * qui raggiungono la connessione dell'handle o vengono scartati con lei.
+ */
+static ssize_t enqueue_frames(int client_fd, conn_t conn, const protocol_frame_t *frames,
+                              size_t count) {
+    outbound_t *out = outbound_lookup(client_fd);
+    if (!out || !frames) return -1;
+
+    // Copia i messaggi prima di prendere il lock della coda
+    out_frame_t *first = NULL, *last = NULL;
+    ssize_t total = build_frames(client_fd, frames, count, &first, &last);
+    if (total < 0) return -1;
+    if (!first) return 0;
+
+    pthread_mutex_lock(&out->lock);
+    if (!out->open || out->overflowed || (!CONN_IS_NONE(conn) && !conn_is_live(conn))) {
+        pthread_mutex_unlock(&out->lock);
+        free_frames(first);
+        return -1;
+    }
+
+    if (out->depth + count > outbound_max_frames) {
+        // Client troppo lento: la lettura vedrà EOF e avvierà la disconnessione
+        LOG_WARN("Coda di uscita piena per FD=%d (%zu messaggi), disconnessione",
+                 client_fd, out->depth);
+        out->overflowed = true;
+        shutdown(client_fd, SHUT_RDWR);
+        pthread_mutex_unlock(&out->lock);
+        free_frames(first);
+        return -1;
+    }
+
+    if (out->tail) out->tail->next = first; else out->head = first;
+    out->tail = last;
+    out->depth += count;
+
+    if (!out->in_pending && !out->writer_armed) {
+        out->in_pending = true;
+        out->next_pending = pending_head;
+        pending_head = out;
+    }
+    pthread_mutex_unlock(&out->lock);
+
+    return total;
+}
+
+ssize_t outbound_enqueue(int client_fd, const protocol_frame_t *frames, size_t count) {
+    return enqueue_frames(client_fd, CONN_NONE, frames, count);
+}
+
+ssize_t outbound_enqueue_conn(conn_t conn, const protocol_frame_t *frames, size_t count) {
+    if (CONN_IS_NONE(conn)) return -1;
+    return enqueue_frames(CONN_FD(conn), conn, frames, count);
+}
+
+void outbound_flush_pending(void) {
+    while (pending_head) {
+        outbound_t *out = pending_head;
+        pending_head = out->next_pending;
+
+        pthread_mutex_lock(&out->lock);
+        out->next_pending = NULL;
+        out->in_pending = false;
+        if (!out->writer_armed) {
+            outbound_write(out);
+        }
+        pthread_mutex_unlock(&out->lock);
+    }
+}
+
+void outbound_reject(int client_fd, const protocol_frame_t *frames, size_t count) {
+    outbound_open(client_fd);
+    outbound_t *out = outbound_lookup(client_fd);
+    linger_entry_t *entry = malloc(sizeof(linger_entry_t));
+    out_frame_t *first = NULL, *last = NULL;
+
+    if (!out || !entry || build_frames(client_fd, frames, count, &first, &last) < 0) {
+        LOG_ERROR("Impossibile rifiutare in modo ordinato FD=%d, chiusura immediata", client_fd);
+        free(entry);
+        outbound_close(client_fd);
+        close(client_fd);
+        return;
+    }
+
+    entry->next = NULL;
+    entry->out = out;
+    entry->deadline_ms = now_ms() + OUTBOUND_LINGER_MS;
+    entry->done = false;
+
+    __atomic_add_fetch(&rejected_total, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&rejected_lingering, 1, __ATOMIC_RELAXED);
+
+    // Socket appena accettato: la risposta entra quasi sempre subito nel buffer
+    pthread_mutex_lock(&out->lock);
+    out->linger = entry;
+    out->head = first;
+    out->tail = last;
+    out->depth = count;
+    outbound_write(out);
+    if (out->linger && !out->writer_armed) {
+        writer_arm(out);
+    }
+    pthread_mutex_unlock(&out->lock);
+
+    pthread_mutex_lock(&linger_lock);
+    bool was_empty = (linger_head == NULL);
+    if (linger_tail) linger_tail->next = entry; else linger_head = entry;
+    linger_tail = entry;
+    pthread_mutex_unlock(&linger_lock);
+
+    // Il thread di scrittura potrebbe dormire senza timeout: va svegliato
+    if (was_empty) {
+        uint64_t one = 1;
+        if (write(writer_wake_fd, &one, sizeof(one)) < 0) {
+            LOG_WARN("Impossibile svegliare il thread di scrittura: %s", strerror(errno));
+        }
+    }
+}
+
+void outbound_get_reject_stats(outbound_reject_stats_t *stats) {
+    if (!stats) return;
+
+    stats->rejected = __atomic_load_n(&rejected_total, __ATOMIC_RELAXED);
+    stats->lingering = __atomic_load_n(&rejected_lingering, __ATOMIC_RELAXED);
+    stats->timed_out = __atomic_load_n(&rejected_timeouts, __ATOMIC_RELAXED);
+}
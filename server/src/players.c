@@ -0,0 +1,89 @@
+#include "players.h"
+#include "server.h"
+#include <pthread.h>
+#include <string.h>
+#include <sys/mman.h>
+
+// ============================================================================
+// STATO DELLA TABELLA
+// ============================================================================
+
+typedef struct {
+    char name[MAX_PLAYER_NAME];         // Nome (immutabile finché refs > 0)
+    uint32_t refs;                      // Riferimenti (atomico)
+    uint32_t next_free;                 // Indice libero successivo (solo se libero)
+} player_entry_t;
+
+// Fine della lista libera
+#define NO_ENTRY UINT32_MAX
+
+static player_entry_t *entries = NULL;  // Indirizzi stabili: ID = indice + 1
+static uint32_t capacity = 0;
+static uint32_t used_high = 0;          // Elementi mai usati oltre questo indice
+static uint32_t free_head = NO_ENTRY;   // Elementi liberati, LIFO (riusa le pagine già toccate)
+static pthread_mutex_t players_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// ============================================================================
+// API PUBBLICA
+// ============================================================================
+
+int players_init(void) {
+    // Margine per i riferimenti di partite non ancora chiuse di client già usciti
+    int max_clients = server_state.max_clients > 0 ? server_state.max_clients : 1;
+    capacity = (uint32_t)max_clients * 2;
+
+    // Solo indirizzi: le pagine vengono impegnate man mano che gli ID servono
+    void *region = mmap(NULL, (size_t)capacity * sizeof(player_entry_t), PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (region == MAP_FAILED) {
+        LOG_ERROR("Impossibile riservare la tabella dei nomi internati (%u giocatori)", capacity);
+        return -1;
+    }
+    entries = region;
+    return 0;
+}
+
+player_id_t players_add(const char *name) {
+    pthread_mutex_lock(&players_lock);
+    uint32_t idx;
+    if (free_head != NO_ENTRY) {
+        idx = free_head;
+        free_head = entries[idx].next_free;
+    } else if (used_high < capacity) {
+        idx = used_high++;
+    } else {
+        pthread_mutex_unlock(&players_lock);
+        LOG_ERROR("Tabella dei nomi internati piena (%u giocatori)", capacity);
+        return PLAYER_NONE;
+    }
+    pthread_mutex_unlock(&players_lock);
+
+    // Nessun altro vede l'elemento finché l'ID non viene pubblicato dal chiamante
+    player_entry_t *entry = &entries[idx];
+    strncpy(entry->name, name, MAX_PLAYER_NAME - 1);
+    entry->name[MAX_PLAYER_NAME - 1] = '\0';
+    __atomic_store_n(&entry->refs, 1, __ATOMIC_RELAXED);
+    return idx + 1;
+}
+
+void players_ref(player_id_t id) {
+    if (id == PLAYER_NONE) return;
+    __atomic_add_fetch(&entries[id - 1].refs, 1, __ATOMIC_RELAXED);
+}
+
+void players_release(player_id_t id) {
+    if (id == PLAYER_NONE) return;
+
+    player_entry_t *entry = &entries[id - 1];
+    if (__atomic_sub_fetch(&entry->refs, 1, __ATOMIC_ACQ_REL) != 0) return;
+
+    pthread_mutex_lock(&players_lock);
+    entry->next_free = free_head;
+    free_head = id - 1;
+    pthread_mutex_unlock(&players_lock);
+}
+
+const char *players_name(player_id_t id) {
+    if (id == PLAYER_NONE) return "";
+    return entries[id - 1].name;
+}
@@ -0,0 +1,566 @@
+#define _GNU_SOURCE // pthread_setaffinity_np
+#include "reactor.h"
+#include "server.h"
+#include "outbound.h"
+#include "workers.h"
+#include "actors.h"
+#include <sched.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+
+#define MAX_EPOLL_EVENTS 64
+
+// ============================================================================
+// STATO DEL REACTOR
+// ============================================================================
+
+/**
+ * Istanza del reactor: un'istanza epoll con il proprio socket in ascolto
+ *
+ * In modalità normale esiste un solo reactor servito da più thread;
+ * in modalità shard ogni core ha il proprio reactor e il proprio listener
+ * SO_REUSEPORT. Lo stato del server (client e lobby) resta unico e condiviso.
+ */
+typedef struct {
+    int epoll_fd;                       // Istanza epoll
+    int listen_fd;                      // Socket in ascolto di questo reactor
+    int unix_fd;                        // Listener AF_UNIX registrato qui (-1 se nessuno)
+    int cpu;                            // Core su cui fissare il thread (-1 = nessuno)
+} reactor_t;
+
+/**
+ * Connessione gestita dal reactor
+ *
+ * Con il pool di worker (o gli shard) la connessione appartiene a un solo
+ * thread alla volta: al reactor finché è armata in epoll, al worker o allo
+ * shard dopo la lettura, di nuovo al reactor quando viene riarmata.
+ */
+typedef struct {
+    connection_t base;                  // fd e decoder (comuni agli altri motori)
+    reactor_t *reactor;                 // Reactor su cui riarmare la connessione
+    bool closed;                        // Il client ha chiuso: disconnetti dopo gli ultimi messaggi
+    actor_msg_t msg;                    // Nodo nella mailbox di uno shard
+    int shard;                          // Ultimo shard che l'ha gestita
+} reactor_conn_t;
+
+// Handler eseguiti dal pool di worker (o dagli shard) invece che dai thread del reactor
+static bool use_workers = false;
+static bool use_actors = false;
+
+// ============================================================================
+// FUNZIONI DI SUPPORTO
+// ============================================================================
+
+static int set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0) return -1;
+    return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+/**
+ * Riarma un fd registrato con EPOLLONESHOT
+ * Il socket server usa data.ptr = NULL, il listener AF_UNIX il reactor
+ * stesso, i client il proprio connection_t
+ */
+static void rearm(reactor_t *reactor, int fd, void *ptr) {
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLONESHOT;
+    ev.data.ptr = ptr;
+    if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_MOD, fd, &ev) < 0) {
+        LOG_ERROR("epoll_ctl MOD fallito per FD=%d: %s", fd, strerror(errno));
+    }
+}
+
+static void close_connection(reactor_t *reactor, reactor_conn_t *conn) {
+    int client_fd = conn->base.fd;
+
+    epoll_ctl(reactor->epoll_fd, EPOLL_CTL_DEL, client_fd, NULL);
+
+    pthread_mutex_lock(&server_state.clients_lock);
+    remove_client(client_fd);
+    pthread_mutex_unlock(&server_state.clients_lock);
+
+    outbound_close(client_fd);
+    close(client_fd);
+    free(conn);
+
+    printf("Client FD=%d disconnesso e rimosso.\n", client_fd);
+    LOG_INFO("Client FD=%d disconnesso e rimosso", client_fd);
+}
+
+// ============================================================================
+// ACCEPT E LETTURA
+// ============================================================================
+
+/**
+ * Registra un client appena accettato nello stato del server e nel reactor
+ */
+static void reactor_register(reactor_t *reactor, int client_fd) {
+    // La coda di uscita deve esistere prima che il client sia visibile ai broadcast
+    outbound_open(client_fd);
+
+    // Controllo e registrazione sotto lo stesso lock: niente race sul limite
+    pthread_mutex_lock(&server_state.clients_lock);
+    int client_idx = add_client(client_fd);
+    int num_clients = server_state.num_clients;
+    pthread_mutex_unlock(&server_state.clients_lock);
+
+    if (client_idx < 0) {
+        outbound_close(client_fd);
+        if (client_idx == -1) {
+            reject_client_server_full(client_fd, num_clients);
+        } else {
+            close(client_fd); // fd oltre l'indice: il server non è pieno (causa nel log)
+        }
+        return;
+    }
+
+    reactor_conn_t *conn = malloc(sizeof(reactor_conn_t));
+    if (!conn) {
+        LOG_ERROR("Errore allocazione memoria per connessione FD=%d", client_fd);
+        pthread_mutex_lock(&server_state.clients_lock);
+        remove_client(client_fd);
+        pthread_mutex_unlock(&server_state.clients_lock);
+        outbound_close(client_fd);
+        close(client_fd);
+        return;
+    }
+    conn->base.fd = client_fd;
+    protocol_decoder_init(&conn->base.decoder);
+    conn->reactor = reactor;
+    conn->closed = false;
+    conn->shard = use_actors ? actors_home_shard(client_fd) : -1;
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLONESHOT;
+    ev.data.ptr = conn;
+    if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, client_fd, &ev) < 0) {
+        LOG_ERROR("epoll_ctl ADD fallito per FD=%d: %s", client_fd, strerror(errno));
+        pthread_mutex_lock(&server_state.clients_lock);
+        remove_client(client_fd);
+        pthread_mutex_unlock(&server_state.clients_lock);
+        outbound_close(client_fd);
+        close(client_fd);
+        free(conn);
+        return;
+    }
+
+    printf("Nuovo client connesso! FD=%d\n", client_fd);
+    LOG_INFO("Nuova connessione client, FD=%d", client_fd);
+}
+
+/**
+ * Svuota l'intera coda di accept a ogni risveglio del listener
+ *
+ * Con centinaia di riconnessioni simultanee un solo accept per evento
+ * lascerebbe la coda del kernel piena e farebbe scartare nuovi SYN.
+ */
+static void reactor_accept(reactor_t *reactor, int listen_fd) {
+    report_accept_queue_overflow(listen_fd);
+
+    int accepted = 0;
+    while (1) {
+        struct sockaddr_storage address;
+        socklen_t addrlen = sizeof(address);
+
+        int client_fd = accept4(listen_fd, (struct sockaddr *)&address, &addrlen,
+                                SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client_fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                LOG_ERROR("Accept fallito: %s", strerror(errno));
+            }
+            break;
+        }
+
+        reactor_register(reactor, client_fd);
+        accepted++;
+    }
+
+    if (accepted > 1) {
+        LOG_DEBUG("Accettate %d connessioni in un solo risveglio (FD=%d)", accepted, listen_fd);
+    }
+}
+
+/**
+ * Legge nel decoder i dati disponibili senza bloccare
+ *
+ * I socket client sono accettati non bloccanti; MSG_DONTWAIT resta per
+ * chiarezza, così la lettura non blocca mai il thread del reactor.
+ *
+ * @return 1 se sono arrivati nuovi byte, 0 se non c'è nulla da leggere,
+ *         -1 se il client ha chiuso la connessione o errore
+ */
+static int connection_fill(connection_t *conn) {
+    ssize_t received = protocol_decoder_fill(&conn->decoder, conn->fd, MSG_DONTWAIT);
+    if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return 0;
+    }
+    if (received <= 0) {
+        if (received == 0) {
+            LOG_INFO("Client FD=%d disconnesso (connessione chiusa)", conn->fd);
+        } else {
+            LOG_WARN("Errore ricezione da FD=%d: %s", conn->fd, strerror(errno));
+        }
+        return -1;
+    }
+    return 1;
+}
+
+/**
+ * Legge i dati disponibili e gestisce tutti i messaggi completi
+ *
+ * @return true se la connessione resta aperta, false se va chiusa
+ */
+static bool connection_read(connection_t *conn) {
+    int ret = connection_fill(conn);
+    if (ret == 0) {
+        return true;
+    }
+    if (ret < 0) {
+        handle_disconnect(conn->fd);
+        return false;
+    }
+
+    return dispatch_decoded_messages(conn->fd, &conn->decoder);
+}
+
+/**
+ * Task del pool: gestisce i messaggi letti dal reactor, poi riarma o chiude
+ *
+ * Il reactor non riarma la connessione prima di sottometterla, quindi
+ * nessun altro thread la legge finché questo task non termina: i
+ * messaggi di uno stesso client restano in ordine.
+ */
+static void connection_task(void *task) {
+    reactor_conn_t *conn = task;
+    int client_fd = conn->base.fd;
+
+    bool keep_open = dispatch_decoded_messages(client_fd, &conn->base.decoder);
+    if (keep_open && conn->closed) {
+        handle_disconnect(client_fd);
+        keep_open = false;
+    }
+
+    if (keep_open) {
+        rearm(conn->reactor, client_fd, conn);
+    } else {
+        close_connection(conn->reactor, conn);
+    }
+}
+
+/**
+ * Messaggio di uno shard: gestisce i messaggi della connessione finché
+ * non ne trova uno destinato alla partita di un altro shard
+ *
+ * In quel caso la connessione, senza essere riarmata, passa nella mailbox
+ * del proprietario: un solo thread alla volta la possiede e i messaggi del
+ * client restano in ordine. Anche la disconnessione gira sullo shard della
+ * partita del client.
+ */
+static void connection_actor_task(actor_msg_t *msg, int shard) {
+    reactor_conn_t *conn = (reactor_conn_t *)((char *)msg - offsetof(reactor_conn_t, msg));
+    int client_fd = conn->base.fd;
+    int next_shard;
+
+    conn->shard = shard;
+    bool keep_open = dispatch_decoded_messages_on_shard(client_fd, &conn->base.decoder,
+                                                        shard, &next_shard);
+    if (next_shard >= 0) {
+        actors_post(next_shard, &conn->msg);
+        return;
+    }
+
+    if (keep_open && conn->closed) {
+        int owner = actors_shard_of_game(message_target_game(client_fd, NULL, NULL));
+        if (owner >= 0 && owner != shard) {
+            actors_post(owner, &conn->msg);
+            return;
+        }
+        handle_disconnect(client_fd);
+        keep_open = false;
+    }
+
+    if (keep_open) {
+        rearm(conn->reactor, client_fd, conn);
+    } else {
+        close_connection(conn->reactor, conn);
+    }
+}
+
+// ============================================================================
+// LOOP DEI THREAD
+// ============================================================================
+
+static void *reactor_thread(void *arg) {
+    reactor_t *reactor = arg;
+    struct epoll_event events[MAX_EPOLL_EVENTS];
+
+    if (reactor->cpu >= 0) {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(reactor->cpu, &cpuset);
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+        if (err != 0) {
+            LOG_WARN("Impossibile fissare il thread sul core %d: %s", reactor->cpu, strerror(err));
+        }
+    }
+
+    while (1) {
+        int n = epoll_wait(reactor->epoll_fd, events, MAX_EPOLL_EVENTS, -1);
+        if (n < 0) {
+            if (errno != EINTR) {
+                LOG_ERROR("epoll_wait fallito: %s", strerror(errno));
+            }
+            continue;
+        }
+
+        for (int i = 0; i < n; i++) {
+            reactor_conn_t *conn = events[i].data.ptr;
+
+            if (conn == NULL) {
+                reactor_accept(reactor, reactor->listen_fd);
+                rearm(reactor, reactor->listen_fd, NULL);
+                continue;
+            }
+            if ((void *)conn == reactor) {
+                reactor_accept(reactor, reactor->unix_fd);
+                rearm(reactor, reactor->unix_fd, reactor);
+                continue;
+            }
+
+            if (!use_workers) {
+                if (connection_read(&conn->base)) {
+                    rearm(reactor, conn->base.fd, conn);
+                } else {
+                    close_connection(reactor, conn);
+                }
+                continue;
+            }
+
+            // Pool o shard: il reactor legge soltanto, decodifica e handler passano a
+            // un worker o allo shard che ha gestito la connessione l'ultima volta
+            int ret = connection_fill(&conn->base);
+            if (ret == 0) {
+                rearm(reactor, conn->base.fd, conn);
+            } else {
+                conn->closed = (ret < 0);
+                if (use_actors) {
+                    actors_post(conn->shard, &conn->msg);
+                } else {
+                    workers_submit(conn);
+                }
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Crea l'istanza epoll di un reactor e vi registra il socket in ascolto
+ */
+static void reactor_init(reactor_t *reactor, int listen_fd, int cpu) {
+    reactor->listen_fd = listen_fd;
+    reactor->unix_fd = -1;
+    reactor->cpu = cpu;
+
+    if (set_nonblocking(listen_fd) < 0) {
+        LOG_ERROR("Impossibile rendere non bloccante il socket server: %s", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    reactor->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (reactor->epoll_fd < 0) {
+        LOG_ERROR("epoll_create1 fallito: %s", strerror(errno));
+        perror("epoll_create1");
+        exit(EXIT_FAILURE);
+    }
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLONESHOT;
+    ev.data.ptr = NULL;
+    if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, listen_fd, &ev) < 0) {
+        LOG_ERROR("epoll_ctl ADD fallito per socket server: %s", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * Registra il listener AF_UNIX (se configurato) nel reactor
+ *
+ * Le connessioni locali seguono poi lo stesso percorso di quelle TCP.
+ */
+static void reactor_add_unix_listener(reactor_t *reactor) {
+    int unix_fd = server_state.unix_fd;
+    if (unix_fd < 0) return;
+
+    if (set_nonblocking(unix_fd) < 0) {
+        LOG_ERROR("Impossibile rendere non bloccante il socket unix: %s", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLONESHOT;
+    ev.data.ptr = reactor;
+    if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, unix_fd, &ev) < 0) {
+        LOG_ERROR("epoll_ctl ADD fallito per socket unix: %s", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    reactor->unix_fd = unix_fd;
+}
+
+/**
+ * Avvia un thread per ogni elemento di reactors[] (anche ripetuti) e attende
+ */
+static void run_threads(reactor_t **reactors, int num_threads) {
+    pthread_t *threads = malloc(num_threads * sizeof(pthread_t));
+    if (!threads) {
+        LOG_ERROR("ERRORE CRITICO: Impossibile allocare memoria per i thread del reactor");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < num_threads; i++) {
+        if (pthread_create(&threads[i], NULL, reactor_thread, reactors[i]) != 0) {
+            LOG_ERROR("Creazione thread reactor %d fallita: %s", i, strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    for (int i = 0; i < num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+}
+
+static int online_cores(void) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (int)cores : 1;
+}
+
+void reactor_run(int server_fd, int num_threads) {
+    if (num_threads <= 0) {
+        num_threads = online_cores();
+    }
+
+    static reactor_t reactor;
+    reactor_init(&reactor, server_fd, -1);
+    reactor_add_unix_listener(&reactor);
+
+    reactor_t **reactors = malloc(num_threads * sizeof(reactor_t *));
+    if (!reactors) {
+        LOG_ERROR("ERRORE CRITICO: Impossibile allocare memoria per i thread del reactor");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < num_threads; i++) {
+        reactors[i] = &reactor;
+    }
+
+    LOG_INFO("Reactor epoll avviato con %d thread", num_threads);
+    printf("Reactor epoll avviato con %d thread\n", num_threads);
+
+    run_threads(reactors, num_threads);
+    free(reactors);
+}
+
+void reactor_run_shards(int server_fd, int num_shards) {
+    int cores = online_cores();
+    if (num_shards <= 0) {
+        num_shards = cores;
+    }
+
+    reactor_t *shards = malloc(num_shards * sizeof(reactor_t));
+    reactor_t **reactors = malloc(num_shards * sizeof(reactor_t *));
+    if (!shards || !reactors) {
+        LOG_ERROR("ERRORE CRITICO: Impossibile allocare memoria per gli shard");
+        exit(EXIT_FAILURE);
+    }
+
+    // Lo shard 0 usa il socket già creato da init_server(), gli altri un proprio listener
+    for (int i = 0; i < num_shards; i++) {
+        int listen_fd = (i == 0) ? server_fd : init_shard_listener(server_config.port);
+        if (listen_fd < 0) {
+            LOG_ERROR("Impossibile creare il listener per lo shard %d", i);
+            exit(EXIT_FAILURE);
+        }
+        reactor_init(&shards[i], listen_fd, i % cores);
+        reactors[i] = &shards[i];
+    }
+    // Le connessioni locali sono poche: basta lo shard 0
+    reactor_add_unix_listener(&shards[0]);
+
+    LOG_INFO("Reactor epoll avviato con %d shard SO_REUSEPORT sulla porta %d",
+             num_shards, server_config.port);
+    printf("Reactor epoll avviato con %d shard sulla porta %d\n", num_shards, server_config.port);
+
+    run_threads(reactors, num_shards);
+    free(reactors);
+    free(shards);
+}
+
+/**
+ * Avvia i thread di I/O di un reactor che passa i messaggi ad altri thread
+ */
+static void run_io_threads(int server_fd, int io_threads) {
+    static reactor_t reactor;
+    reactor_init(&reactor, server_fd, -1);
+    reactor_add_unix_listener(&reactor);
+
+    reactor_t **reactors = malloc(io_threads * sizeof(reactor_t *));
+    if (!reactors) {
+        LOG_ERROR("ERRORE CRITICO: Impossibile allocare memoria per i thread del reactor");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < io_threads; i++) {
+        reactors[i] = &reactor;
+    }
+
+    run_threads(reactors, io_threads);
+    free(reactors);
+}
+
+void reactor_run_pool(int server_fd, int io_threads, int num_workers) {
+    if (io_threads <= 0) {
+        io_threads = 1;
+    }
+
+    num_workers = workers_start(num_workers, connection_task);
+    if (num_workers < 0) {
+        LOG_ERROR("ERRORE CRITICO: Impossibile avviare il pool di worker");
+        exit(EXIT_FAILURE);
+    }
+    use_workers = true;
+
+    LOG_INFO("Reactor epoll avviato con %d thread di I/O e %d worker", io_threads, num_workers);
+    printf("Reactor epoll avviato con %d thread di I/O e %d worker\n", io_threads, num_workers);
+
+    run_io_threads(server_fd, io_threads);
+}
+
+void reactor_run_actors(int server_fd, int io_threads, int num_shards) {
+    if (io_threads <= 0) {
+        io_threads = 1;
+    }
+
+    num_shards = actors_start(num_shards, connection_actor_task);
+    if (num_shards < 0) {
+        LOG_ERROR("ERRORE CRITICO: Impossibile avviare gli shard delle partite");
+        exit(EXIT_FAILURE);
+    }
+    use_workers = true;
+    use_actors = true;
+
+    LOG_INFO("Reactor epoll avviato con %d thread di I/O e %d shard proprietari delle partite",
+             io_threads, num_shards);
+    printf("Reactor epoll avviato con %d thread di I/O e %d shard\n", io_threads, num_shards);
+
+    run_io_threads(server_fd, io_threads);
+}
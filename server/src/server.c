@@ -1,4 +1,12 @@
+#define _GNU_SOURCE // accept4
 #include "server.h"
+#include "uring.h"
+#include "outbound.h"
+#include "timers.h"
+#include "names.h"
+#include "lobby.h"
+#include "actors.h"
+#include "tables.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -7,9 +15,19 @@
 #include <arpa/inet.h>
 #include <time.h>
 #include <stdbool.h>
+#include <netinet/tcp.h>
+#include <stddef.h>
+#include <sys/un.h>
+#include <sys/resource.h>
 
 #define MAX_PORT_ATTEMPTS 10
+// Limite all'indice per fd dei client se RLIMIT_NOFILE è illimitato
+#define MAX_INDEXED_FDS (1 << 20)
 #define BUFFER_SIZE 1024
+// game_id = 'G' + slot (6 cifre esadecimali) + generazione (8 cifre esadecimali)
+#define GAME_ID_SLOT_DIGITS 6
+#define GAME_ID_GEN_DIGITS 8
+#define GAME_ID_MAX_SLOTS (1 << (4 * GAME_ID_SLOT_DIGITS))
 
 // ============================================================================
 // STATO GLOBALE DEL SERVER
@@ -17,50 +35,98 @@
 
 server_state_t server_state;
 
+// Generazione assegnata all'ultima partita creata (protetta da server_state.lobby_lock)
+static uint32_t last_game_generation = 0;
+
 // ============================================================================
 // FUNZIONI PER LA GESTIONE DEL SERVER
 // ============================================================================
 
 void init_server_state() {
-    pthread_mutex_init(&server_state.mutex, NULL);
+    pthread_mutex_init(&server_state.clients_lock, NULL);
+    pthread_mutex_init(&server_state.lobby_lock, NULL);
     
     // Leggi i limiti dalla configurazione
     server_state.max_clients = server_config.max_clients;
     server_state.max_games = server_config.max_games;
+    if (server_state.max_games > GAME_ID_MAX_SLOTS) {
+        LOG_WARN("max_games=%d oltre il limite codificabile nei game_id, uso %d",
+                 server_state.max_games, GAME_ID_MAX_SLOTS);
+        server_state.max_games = GAME_ID_MAX_SLOTS;
+    }
     
     LOG_INFO("Inizializzazione stato server: max_clients=%d, max_games=%d", 
              server_state.max_clients, server_state.max_games);
     
-    // Alloca array dinamici
-    server_state.clients = (client_info_t*)malloc(server_state.max_clients * sizeof(client_info_t));
-    if (!server_state.clients) {
-        LOG_ERROR("ERRORE CRITICO: Impossibile allocare memoria per client array");
-        fprintf(stderr, "ERRORE: Impossibile allocare memoria per %d client\n", server_state.max_clients);
+    // Tabelle segmentate: i limiti riservano solo indirizzi, la memoria segue il carico
+    if (tables_init() < 0) {
+        fprintf(stderr, "ERRORE: Impossibile riservare le tabelle per %d client e %d partite\n",
+                server_state.max_clients, server_state.max_games);
         exit(EXIT_FAILURE);
     }
-
-    server_state.games = (game_session_t*)malloc(server_state.max_games * sizeof(game_session_t));
-    if (!server_state.games) {
-        LOG_ERROR("ERRORE CRITICO: Impossibile allocare memoria per games array");
-        fprintf(stderr, "ERRORE: Impossibile allocare memoria per %d partite\n", server_state.max_games);
-        free(server_state.clients);
+    
+    // Indice fd -> client: un fd non può superare RLIMIT_NOFILE
+    struct rlimit limit;
+    int fd_limit = MAX_INDEXED_FDS;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY &&
+        limit.rlim_cur < MAX_INDEXED_FDS) {
+        fd_limit = (int)limit.rlim_cur;
+    }
+    server_state.client_by_fd = (int*)malloc(fd_limit * sizeof(int));
+    if (!server_state.client_by_fd) {
+        LOG_ERROR("ERRORE CRITICO: Impossibile allocare memoria per l'indice dei client");
+        fprintf(stderr, "ERRORE: Impossibile allocare l'indice per %d fd\n", fd_limit);
         exit(EXIT_FAILURE);
     }
+    server_state.client_by_fd_size = fd_limit;
+    for (int i = 0; i < fd_limit; i++) {
+        server_state.client_by_fd[i] = -1;
+    }
     
-    // Inizializza tutti i client come non attivi
-    for (int i = 0; i < server_state.max_clients; i++) {
-        server_state.clients[i].fd = -1;
-        server_state.clients[i].game_index = -1;
+    // Generazioni dei fd per gli handle delle connessioni (tutte pari: nessun client)
+    server_state.conn_generation = (uint32_t*)calloc(fd_limit, sizeof(uint32_t));
+    if (!server_state.conn_generation) {
+        LOG_ERROR("ERRORE CRITICO: Impossibile allocare le generazioni delle connessioni");
+        fprintf(stderr, "ERRORE: Impossibile allocare le generazioni per %d fd\n", fd_limit);
+        exit(EXIT_FAILURE);
     }
     
-    // Inizializza tutte le partite come non attive
-    for (int i = 0; i < server_state.max_games; i++) {
-        server_state.games[i].active = 0;
-        server_state.games[i].pending_join_fd = -1;
+    // Partita di ogni fd per le letture senza lock (nessun client: nessuna partita)
+    server_state.client_game = (uint64_t*)malloc(fd_limit * sizeof(uint64_t));
+    if (!server_state.client_game) {
+        LOG_ERROR("ERRORE CRITICO: Impossibile allocare le partite delle connessioni");
+        fprintf(stderr, "ERRORE: Impossibile allocare le partite per %d fd\n", fd_limit);
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < fd_limit; i++) {
+        server_state.client_game[i] = CLIENT_GAME_NONE;
+    }
+    
+    // Indice dei nomi per i controlli di unicità in handle_register()
+    if (names_init() < 0) {
+        fprintf(stderr, "ERRORE: Impossibile allocare l'indice dei nomi\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    // Nomi internati: le partite indicano i giocatori con un ID a 32 bit
+    if (players_init() < 0) {
+        fprintf(stderr, "ERRORE: Impossibile riservare la tabella dei nomi internati\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    server_state.waiting_head = -1;
+    server_state.waiting_tail = -1;
+    server_state.num_waiting = 0;
+    
+    // Lista partite pubblicata per handle_list_games()
+    if (lobby_init() < 0) {
+        fprintf(stderr, "ERRORE: Impossibile allocare lo snapshot della lobby\n");
+        exit(EXIT_FAILURE);
     }
     
     server_state.num_clients = 0;
     server_state.num_games = 0;
+    server_state.unix_fd = -1;
     
     LOG_INFO("Stato server inizializzato con successo: %d client, %d partite", 
              server_state.max_clients, server_state.max_games);
@@ -87,6 +153,16 @@ int init_server(int requested_port) {
         return -1;
     }
 
+    // Con gli shard epoll gli altri listener si legano alla stessa porta
+    bool reuse_port = get_io_mode_from_string(server_config.io_mode) == IO_MODE_EPOLL &&
+                      server_config.shards > 1;
+    if (reuse_port && setsockopt(server_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt))) {
+        LOG_ERROR("setsockopt SO_REUSEPORT fallito: %s", strerror(errno));
+        perror("setsockopt");
+        close(server_fd);
+        return -1;
+    }
+
     // Configura l'indirizzo di base
     address.sin_family = AF_INET;
     address.sin_addr.s_addr = INADDR_ANY;
@@ -99,8 +175,10 @@ int init_server(int requested_port) {
         return -1;
     }
 
-    // Listen - usa max_clients dalla configurazione
-    if (listen(server_fd, server_config.max_clients) < 0) {
+    configure_fast_onboarding(server_fd);
+
+    // Listen - coda di accept dimensionata da backlog_size
+    if (listen(server_fd, listen_backlog()) < 0) {
         LOG_ERROR("Listen fallito: %s", strerror(errno));
         perror("Listen fallito");
         close(server_fd);
@@ -108,7 +186,8 @@ int init_server(int requested_port) {
     }
 
     printf("Server in ascolto sulla porta %d...\n", current_port);
-    LOG_INFO("Server in ascolto sulla porta %d, max client: %d", current_port, server_config.max_clients);
+    LOG_INFO("Server in ascolto sulla porta %d, max client: %d, backlog: %d",
+             current_port, server_config.max_clients, listen_backlog());
 
     // Aggiorna la configurazione globale con la porta effettivamente utilizzata
     server_config.port = current_port;
@@ -116,36 +195,220 @@ int init_server(int requested_port) {
     return server_fd;
 }
 
-void start_server(int server_fd) {
+int init_shard_listener(int port) {
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        LOG_ERROR("Creazione socket shard fallita: %s", strerror(errno));
+        return -1;
+    }
+
+    int opt = 1;
+    if (setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) ||
+        setsockopt(listen_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt))) {
+        LOG_ERROR("setsockopt per socket shard fallito: %s", strerror(errno));
+        close(listen_fd);
+        return -1;
+    }
+
     struct sockaddr_in address;
-    int addrlen = sizeof(address);
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = INADDR_ANY;
+    address.sin_port = htons(port);
+
+    if (bind(listen_fd, (struct sockaddr *)&address, sizeof(address)) < 0) {
+        LOG_ERROR("Bind socket shard sulla porta %d fallito: %s", port, strerror(errno));
+        close(listen_fd);
+        return -1;
+    }
+
+    configure_fast_onboarding(listen_fd);
+
+    if (listen(listen_fd, listen_backlog()) < 0) {
+        LOG_ERROR("Listen socket shard fallito: %s", strerror(errno));
+        close(listen_fd);
+        return -1;
+    }
+
+    LOG_DEBUG("Listener shard creato sulla porta %d, FD=%d", port, listen_fd);
+    return listen_fd;
+}
+
+void configure_fast_onboarding(int listen_fd) {
+    if (server_config.tcp_fastopen > 0) {
+        int qlen = server_config.tcp_fastopen;
+        if (setsockopt(listen_fd, IPPROTO_TCP, TCP_FASTOPEN, &qlen, sizeof(qlen)) < 0) {
+            LOG_WARN("TCP_FASTOPEN non disponibile su FD=%d: %s", listen_fd, strerror(errno));
+        } else {
+            // Senza il bit 2 del sysctl il kernel ignora l'opzione lato server
+            FILE *file = fopen("/proc/sys/net/ipv4/tcp_fastopen", "r");
+            int mode = 0;
+            if (file) {
+                if (fscanf(file, "%d", &mode) != 1) mode = 0;
+                fclose(file);
+            }
+            if (file && !(mode & 2)) {
+                LOG_WARN("TCP Fast Open lato server disattivato dal kernel "
+                         "(net.ipv4.tcp_fastopen=%d, serve il bit 2)", mode);
+            }
+            LOG_DEBUG("TCP_FASTOPEN abilitato su FD=%d (coda %d)", listen_fd, qlen);
+        }
+    }
+    
+    if (server_config.defer_accept > 0) {
+        int seconds = server_config.defer_accept;
+        if (setsockopt(listen_fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &seconds, sizeof(seconds)) < 0) {
+            LOG_WARN("TCP_DEFER_ACCEPT non disponibile su FD=%d: %s", listen_fd, strerror(errno));
+        } else {
+            LOG_DEBUG("TCP_DEFER_ACCEPT abilitato su FD=%d (%d sec)", listen_fd, seconds);
+        }
+    }
+}
+
+int init_unix_server(const char *path) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    
+    size_t path_len = strlen(path);
+    if (path_len == 0 || path_len >= sizeof(address.sun_path)) {
+        LOG_ERROR("Percorso del socket unix non valido: '%s'", path);
+        return -1;
+    }
+    
+    // '@' iniziale: namespace astratto, il nome inizia con un byte nullo
+    bool abstract = (path[0] == '@');
+    memcpy(address.sun_path, path, path_len);
+    if (abstract) {
+        address.sun_path[0] = '\0';
+    }
+    socklen_t addrlen = offsetof(struct sockaddr_un, sun_path) + path_len;
+    
+    int unix_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (unix_fd < 0) {
+        LOG_ERROR("Creazione socket unix fallita: %s", strerror(errno));
+        return -1;
+    }
+    
+    // Un file rimasto da un'esecuzione precedente impedirebbe il bind
+    if (!abstract && unlink(path) < 0 && errno != ENOENT) {
+        LOG_WARN("Impossibile rimuovere il vecchio socket %s: %s", path, strerror(errno));
+    }
+    
+    if (bind(unix_fd, (struct sockaddr *)&address, addrlen) < 0) {
+        LOG_ERROR("Bind del socket unix %s fallito: %s", path, strerror(errno));
+        close(unix_fd);
+        return -1;
+    }
+    
+    if (listen(unix_fd, listen_backlog()) < 0) {
+        LOG_ERROR("Listen socket unix fallito: %s", strerror(errno));
+        close(unix_fd);
+        return -1;
+    }
+    
+    printf("Server in ascolto sul socket unix %s...\n", path);
+    LOG_INFO("Server in ascolto sul socket unix %s%s, FD=%d",
+             path, abstract ? " (namespace astratto)" : "", unix_fd);
+    return unix_fd;
+}
+
+int listen_backlog(void) {
+    return server_config.backlog_size > 0 ? server_config.backlog_size : server_config.max_clients;
+}
+
+/**
+ * Legge il contatore TcpExt ListenOverflows da /proc/net/netstat
+ * 
+ * @return Valore del contatore, 0 se non disponibile
+ */
+static unsigned long read_listen_overflows(void) {
+    FILE *file = fopen("/proc/net/netstat", "r");
+    if (!file) return 0;
+    
+    // Il file alterna una riga di nomi e una di valori per ogni gruppo
+    char names[4096], values[4096];
+    unsigned long result = 0;
+    while (fgets(names, sizeof(names), file) && fgets(values, sizeof(values), file)) {
+        if (strncmp(names, "TcpExt:", 7) != 0) continue;
+        
+        char *name_save, *value_save;
+        char *name = strtok_r(names, " \n", &name_save);
+        char *value = strtok_r(values, " \n", &value_save);
+        while (name && value) {
+            if (strcmp(name, "ListenOverflows") == 0) {
+                result = strtoul(value, NULL, 10);
+                break;
+            }
+            name = strtok_r(NULL, " \n", &name_save);
+            value = strtok_r(NULL, " \n", &value_save);
+        }
+        break;
+    }
+    
+    fclose(file);
+    return result;
+}
+
+void report_accept_queue_overflow(int listen_fd) {
+    // Al più un controllo al secondo: getsockopt a ogni accept costerebbe una syscall in più
+    static time_t last_check = 0;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+    time_t previous_check = __atomic_load_n(&last_check, __ATOMIC_RELAXED);
+    if (now.tv_sec == previous_check ||
+        !__atomic_compare_exchange_n(&last_check, &previous_check, now.tv_sec, false,
+                                     __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        return;
+    }
+    
+    // Su un socket in ascolto tcpi_unacked è la coda attuale, tcpi_sacked il backlog
+    struct tcp_info info;
+    socklen_t len = sizeof(info);
+    if (getsockopt(listen_fd, IPPROTO_TCP, TCP_INFO, &info, &len) < 0) {
+        return;
+    }
+    if (info.tcpi_sacked == 0 || info.tcpi_unacked < info.tcpi_sacked) {
+        return;
+    }
+    
+    static unsigned long last_overflows = 0;
+    unsigned long overflows = read_listen_overflows();
+    unsigned long previous = __atomic_exchange_n(&last_overflows, overflows, __ATOMIC_RELAXED);
+    
+    LOG_WARN("Coda di accept satura su FD=%d (%u/%u): ListenOverflows di sistema=%lu (+%lu)",
+             listen_fd, info.tcpi_unacked, info.tcpi_sacked, overflows,
+             previous ? overflows - previous : 0);
+}
+
+/**
+ * Loop di accept: un thread dedicato per ogni client accettato
+ * 
+ * @param server_fd Socket in ascolto (TCP o AF_UNIX)
+ */
+static void accept_clients(int server_fd) {
+    struct sockaddr_storage address;
+    socklen_t addrlen;
 
     while (1) {
+        report_accept_queue_overflow(server_fd);
+        
         int new_client_fd;
-        if ((new_client_fd = accept(server_fd, (struct sockaddr *)&address, (socklen_t *)&addrlen)) < 0) {
+        addrlen = sizeof(address);
+        if ((new_client_fd = accept4(server_fd, (struct sockaddr *)&address,
+                                     &addrlen, SOCK_CLOEXEC)) < 0) {
             LOG_ERROR("Accept fallito: %s", strerror(errno));
             perror("Accept fallito");
             continue;
         }
 
         // Controlla se il server è pieno PRIMA di allocare risorse
-        pthread_mutex_lock(&server_state.mutex);
-        bool is_full = (server_state.num_clients >= server_state.max_clients);
-        pthread_mutex_unlock(&server_state.mutex);
-
-        if (is_full) { // Server pieno: rifiuta immediatamente senza creare thread
-            LOG_WARN("Server pieno (%d/%d client), rifiuto connessione FD=%d", 
-                     server_state.num_clients, server_state.max_clients, new_client_fd);
-            printf("⚠️  Connessione rifiutata (server pieno %d/%d): FD=%d\n",
-                   server_state.num_clients, server_state.max_clients, new_client_fd);
-            
-            response_register_t error_response;
-            error_response.status = STATUS_ERROR;
-            error_response.error_code = ERR_SERVER_FULL;
-            protocol_send(new_client_fd, MSG_RESPONSE, &error_response, sizeof(error_response), 0);
-            
-            usleep(500000); // 500ms per assicurarsi che il messaggio venga ricevuto dal client
-            close(new_client_fd);
+        pthread_mutex_lock(&server_state.clients_lock);
+        int num_clients = server_state.num_clients;
+        pthread_mutex_unlock(&server_state.clients_lock);
+
+        if (num_clients >= server_state.max_clients) { // Server pieno: rifiuta senza creare thread
+            reject_client_server_full(new_client_fd, num_clients);
             continue;
         }
 
@@ -165,13 +428,34 @@ void start_server(int server_fd) {
             close(*client_fd);
             free(client_fd);
         } else {
-            LOG_DEBUG("Thread creato per gestire client FD=%d", *client_fd);
+            // client_fd appartiene ormai al thread (che lo libera): si usa la copia locale
+            LOG_DEBUG("Thread creato per gestire client FD=%d", new_client_fd);
             // Non servono join qui: lasciamo i thread staccati
             pthread_detach(tid);
         }
     }
 }
 
+static void *unix_accept_thread(void *arg) {
+    (void)arg;
+    accept_clients(server_state.unix_fd);
+    return NULL;
+}
+
+void start_server(int server_fd) {
+    // Le connessioni locali hanno il proprio acceptor, con lo stesso percorso dei client TCP
+    if (server_state.unix_fd >= 0) {
+        pthread_t tid;
+        if (pthread_create(&tid, NULL, unix_accept_thread, NULL) != 0) {
+            LOG_ERROR("Creazione thread di accept per il socket unix fallita");
+        } else {
+            pthread_detach(tid);
+        }
+    }
+    
+    accept_clients(server_fd);
+}
+
 void *handle_client(void *arg) {
     int client_fd = *(int *)arg;
     free(arg); // liberiamo memoria allocata per il socket descriptor
@@ -179,118 +463,258 @@ void *handle_client(void *arg) {
     printf("Nuovo client connesso! FD=%d\n", client_fd);
     LOG_INFO("Nuova connessione client, FD=%d", client_fd);
     
+    // La coda di uscita deve esistere prima che il client sia visibile ai broadcast
+    outbound_open(client_fd);
+    
     // Aggiungi il client allo stato del server
-    pthread_mutex_lock(&server_state.mutex);
+    pthread_mutex_lock(&server_state.clients_lock);
     int client_idx = add_client(client_fd);
-    pthread_mutex_unlock(&server_state.mutex);
+    pthread_mutex_unlock(&server_state.clients_lock);
     
-    // Questo non dovrebbe mai accadere perché controlliamo prima in start_server
-    if (client_idx == -1) {
-        LOG_ERROR("ERRORE CRITICO: Impossibile aggiungere client FD=%d nonostante controllo preventivo", client_fd);
+    // -1 non dovrebbe mai accadere perché controlliamo prima in start_server;
+    // -2 (fd oltre l'indice) è già nel log di add_client()
+    if (client_idx < 0) {
+        if (client_idx == -1) {
+            LOG_ERROR("ERRORE CRITICO: Impossibile aggiungere client FD=%d nonostante controllo preventivo", client_fd);
+        }
+        outbound_close(client_fd);
         close(client_fd);
         pthread_exit(NULL);
     }
     
-    bool should_run = true;
-    // Loop principale: ricevi e gestisci messaggi
+    // Il decoder è grande (due messaggi massimi): allocato una volta per connessione
+    protocol_decoder_t *decoder = malloc(sizeof(protocol_decoder_t));
+    if (!decoder) {
+        LOG_ERROR("Errore allocazione memoria per decoder FD=%d", client_fd);
+    } else {
+        protocol_decoder_init(decoder);
+    }
+    
+    bool should_run = decoder != NULL;
+    // Loop principale: una recv() legge tutti i byte disponibili,
+    // poi si gestiscono tutti i messaggi completi ricevuti
     while (should_run) {
-        protocol_header_t header;
-        
-        // Ricevi l'header
-        ssize_t received = protocol_recv_header(client_fd, &header);
+        ssize_t received = protocol_decoder_fill(decoder, client_fd, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
         if (received <= 0) {
             if (received == 0) {
                 LOG_INFO("Client FD=%d disconnesso (connessione chiusa)", client_fd);
             } else {
-                LOG_WARN("Errore ricezione header da FD=%d: %s", client_fd, strerror(errno));
+                LOG_WARN("Errore ricezione da FD=%d: %s", client_fd, strerror(errno));
             }
             handle_disconnect(client_fd); 
             break;
         }
         
-        LOG_DEBUG("Header ricevuto da FD=%d: type=%d, length=%d, seq=%d",
-                 client_fd, header.msg_type, header.length, header.seq_id);
-        
-        // Ricevi il payload se presente
-        void *payload = NULL;
-        if (header.length > 0) {
-            // Limita dimensione payload per sicurezza
-            if (header.length > MAX_MESSAGE_SIZE) {
-                LOG_ERROR("Payload troppo grande da FD=%d: %d bytes", client_fd, header.length);
-                break;
-            }
+        should_run = dispatch_decoded_messages(client_fd, decoder);
+    }
+    
+    free(decoder);
+    
+    pthread_mutex_lock(&server_state.clients_lock);
+    remove_client(client_fd);
+    pthread_mutex_unlock(&server_state.clients_lock);
+    
+    outbound_close(client_fd);
+    close(client_fd);
+    printf("Client FD=%d disconnesso e rimosso.\n", client_fd);
+    LOG_INFO("Client FD=%d disconnesso e rimosso", client_fd);
+    
+    pthread_exit(NULL);
+}
+
+bool dispatch_message(int client_fd, const protocol_header_t *header, const void *payload) {
+    switch (header->msg_type) {
+        case MSG_REGISTER:
+            handle_register(client_fd, payload, header->length);
+            break;
             
-            payload = malloc(header.length);
-            if (!payload) {
-                LOG_ERROR("Errore allocazione memoria per payload (%d bytes)", header.length);
-                break;
-            }
+        case MSG_CREATE_GAME:
+            handle_create_game(client_fd);
+            break;
             
-            received = protocol_recv_payload(client_fd, payload, header.length);
-            if (received <= 0) {
-                LOG_ERROR("Errore ricezione payload da FD=%d", client_fd);
-                free(payload);
-                break;
+        case MSG_LIST_GAMES:
+            handle_list_games(client_fd);
+            break;
+            
+        case MSG_JOIN_GAME:
+            handle_join_game(client_fd, payload, header->length);
+            break;
+            
+        case MSG_ACCEPT_JOIN:
+            handle_accept_join(client_fd, payload, header->length);
+            break;
+            
+        case MSG_MAKE_MOVE:
+            handle_make_move(client_fd, payload, header->length);
+            break;
+            
+        case MSG_LEAVE_GAME:
+            handle_leave_game(client_fd);
+            break;
+
+        //NOTE: manca -> case MSG_NEW_GAME:
+            
+        case MSG_QUIT:
+            handle_quit(client_fd);
+            return false;
+            
+        default:
+            LOG_WARN("Tipo messaggio sconosciuto da FD=%d: %d", client_fd, header->msg_type);
+            break;
+    }
+    
+    return true;
+}
+
+/**
+ * Un client è sorvegliato per inattività solo fuori dalle partite
+ *
+ * In lobby con una partita creata, in attesa di una risposta di join o
+ * della mossa avversaria il client non ha nulla da inviare (e non manda
+ * keepalive): connection_timeout lo disconnetterebbe. Solo i client
+ * CONNECTED e REGISTERED hanno game_index < 0.
+ */
+static bool idle_watched(int game_index) {
+    return game_index < 0;
+}
+
+/**
+ * Riarma il timer di inattività, o lo disarma per un client legato a una partita
+ *
+ * Senza lock: la partita si legge da server_state.client_game. Se un altro
+ * thread la cambia nel frattempo (set_client_game()), dopo il proprio
+ * timers_watch_idle() sotto il lock della ruota, la rilettura successiva
+ * la vede e il timer viene corretto.
+ */
+static void arm_idle_timer(int client_fd) {
+    if (CONN_IS_NONE(conn_of_fd(client_fd))) {
+        timers_cancel(client_fd);
+        return;
+    }
+    uint64_t *ref = &server_state.client_game[client_fd];
+    int game_index = CLIENT_GAME_INDEX(__atomic_load_n(ref, __ATOMIC_ACQUIRE));
+    for (;;) {
+        timers_arm(client_fd, idle_watched(game_index) ? TIMER_IDLE : TIMER_NONE);
+        int current = CLIENT_GAME_INDEX(__atomic_load_n(ref, __ATOMIC_ACQUIRE));
+        if (idle_watched(current) == idle_watched(game_index)) break;
+        game_index = current;
+    }
+}
+
+bool dispatch_decoded_messages(int client_fd, protocol_decoder_t *decoder) {
+    return dispatch_decoded_messages_on_shard(client_fd, decoder, -1, NULL);
+}
+
+bool dispatch_decoded_messages_on_shard(int client_fd, protocol_decoder_t *decoder,
+                                        int shard, int *next_shard) {
+    protocol_header_t header;
+    const void *payload;
+    int ret;
+    
+    if (next_shard) *next_shard = -1;
+    
+    while (1) {
+        size_t start = decoder->start;
+        if ((ret = protocol_decoder_next(decoder, &header, &payload)) <= 0) break;
+        
+        // Partita di un altro shard: il messaggio resta nel decoder e la connessione passa
+        // al proprietario, che lo gestirà per primo (l'ordine del client è preservato)
+        if (shard >= 0) {
+            int owner = actors_shard_of_game(message_target_game(client_fd, &header, payload));
+            if (owner >= 0 && owner != shard) {
+                decoder->start = start;
+                *next_shard = owner;
+                return true;
             }
         }
         
-        // Dispatch al handler appropriato
-        switch (header.msg_type) {
-            case MSG_REGISTER:
-                handle_register(client_fd, payload, header.length);
-                break;
-                
-            case MSG_CREATE_GAME:
-                handle_create_game(client_fd);
-                break;
-                
-            case MSG_LIST_GAMES:
-                handle_list_games(client_fd);
-                break;
-                
-            case MSG_JOIN_GAME:
-                handle_join_game(client_fd, payload, header.length);
-                break;
-                
-            case MSG_ACCEPT_JOIN:
-                handle_accept_join(client_fd, payload, header.length);
-                break;
-                
-            case MSG_MAKE_MOVE:
-                handle_make_move(client_fd, payload, header.length);
-                break;
-                
-            case MSG_LEAVE_GAME:
-                handle_leave_game(client_fd);
-                break;
-
-            //NOTE: manca -> case MSG_NEW_GAME:
-                
-            case MSG_QUIT:
-                handle_quit(client_fd);
-                free(payload);
-                should_run = false; 
-                break;
-                
-            default:
-                LOG_WARN("Tipo messaggio sconosciuto da FD=%d: %d", client_fd, header.msg_type);
-                break;
-        }
+        LOG_DEBUG("Header ricevuto da FD=%d: type=%d, length=%d, seq=%d",
+                 client_fd, header.msg_type, header.length, header.seq_id);
         
-        if (payload) {
-            free(payload);
+        bool keep_open = dispatch_message(client_fd, &header, payload);
+        
+        // Le risposte accodate dagli handler vengono scritte fuori dai lock dello stato
+        outbound_flush_pending();
+        
+        if (!keep_open) {
+            return false; // MSG_QUIT: handle_quit ha già fatto il cleanup
         }
     }
     
-    pthread_mutex_lock(&server_state.mutex);
-    remove_client(client_fd);
-    pthread_mutex_unlock(&server_state.mutex);
+    if (ret < 0) {
+        LOG_ERROR("Payload troppo grande da FD=%d: %d bytes", client_fd, header.length);
+        handle_disconnect(client_fd);
+        return false;
+    }
     
-    close(client_fd);
-    printf("Client FD=%d disconnesso e rimosso.\n", client_fd);
-    LOG_INFO("Client FD=%d disconnesso e rimosso", client_fd);
+    // Riarma il timer in base a ciò che resta nel decoder e allo stato del client
+    size_t pending = decoder->end - decoder->start;
+    if (pending == 0) {
+        arm_idle_timer(client_fd);
+    } else if (pending < sizeof(protocol_header_t)) {
+        timers_arm(client_fd, TIMER_HEADER);
+    } else {
+        timers_arm(client_fd, TIMER_PAYLOAD);
+    }
     
-    pthread_exit(NULL);
+    return true;
+}
+
+ssize_t send_to_client(int client_fd, uint8_t msg_type, const void *payload, size_t payload_size) {
+    // Nel motore io_uring l'invio viene accodato sul ring del thread corrente
+    if (uring_is_active()) {
+        return uring_send(client_fd, msg_type, payload, payload_size);
+    }
+    // Altrimenti si accoda: la scrittura avviene in outbound_flush_pending()
+    protocol_frame_t frame = { msg_type, payload, payload_size, 0 };
+    return outbound_enqueue(client_fd, &frame, 1);
+}
+
+ssize_t send_to_conn(conn_t conn, uint8_t msg_type, const void *payload, size_t payload_size) {
+    // Il motore io_uring è a thread singolo: nessuno chiude la connessione tra verifica e invio
+    if (uring_is_active()) {
+        if (!conn_is_live(conn)) return -1;
+        return uring_send(CONN_FD(conn), msg_type, payload, payload_size);
+    }
+    protocol_frame_t frame = { msg_type, payload, payload_size, 0 };
+    return outbound_enqueue_conn(conn, &frame, 1);
+}
+
+ssize_t send_batch_to_client(int client_fd, const protocol_frame_t *frames, size_t count) {
+    if (uring_is_active()) {
+        ssize_t total = 0;
+        for (size_t i = 0; i < count; i++) {
+            ssize_t sent = uring_send(client_fd, frames[i].msg_type,
+                                      frames[i].payload, frames[i].payload_size);
+            if (sent < 0) return -1;
+            total += sent;
+        }
+        return total;
+    }
+    return outbound_enqueue(client_fd, frames, count);
+}
+
+void reject_client_server_full(int client_fd, int num_clients) {
+    // Solo il file di log: stdout verso un terminale o una pipe lenta può bloccare,
+    // e qui si è sul thread dell'acceptor (reactor o ring io_uring)
+    LOG_WARN("Server pieno (%d/%d client), rifiuto connessione FD=%d", 
+             num_clients, server_state.max_clients, client_fd);
+    
+    response_register_t error_response;
+    error_response.status = STATUS_ERROR;
+    error_response.error_code = ERR_SERVER_FULL;
+    
+    // Invio, shutdown e chiusura differita avvengono senza bloccare l'acceptor
+    protocol_frame_t frame = { MSG_RESPONSE, &error_response, sizeof(error_response), 0 };
+    outbound_reject(client_fd, &frame, 1);
+    
+    outbound_reject_stats_t stats;
+    outbound_get_reject_stats(&stats);
+    LOG_DEBUG("Connessioni rifiutate: %lu totali, %lu in chiusura, %lu chiuse per timeout",
+             stats.rejected, stats.lingering, stats.timed_out);
 }
 
 int bind_to_available_port(int server_fd, struct sockaddr_in *address, int starting_port) {
@@ -337,25 +761,42 @@ int bind_to_available_port(int server_fd, struct sockaddr_in *address, int start
 // FUNZIONI DI GESTIONE CLIENT
 // ============================================================================
 
+/**
+ * Pubblica game_index e player_index di un client per le letture senza lock
+ *
+ * @note Richiede che server_state.clients_lock sia già acquisito
+ */
+static void publish_client_game(const client_info_t *client) {
+    __atomic_store_n(&server_state.client_game[client->fd],
+                     CLIENT_GAME_MAKE(client->game_index, client->player_index), __ATOMIC_RELEASE);
+}
+
 int find_client_by_fd(int fd) {
-    for (int i = 0; i < server_state.num_clients; i++) {
-        if (server_state.clients[i].fd == fd) {
-            return i;
-        }
+    if (fd < 0 || fd >= server_state.client_by_fd_size) {
+        return -1;
     }
-    return -1;
+    return server_state.client_by_fd[fd];
 }
 
 int find_client_by_name(const char *name) {
-    if (!name) return -1;
-    
-    for (int i = 0; i < server_state.num_clients; i++) {
-        if (server_state.clients[i].status != CLIENT_CONNECTED &&
-            strcmp(server_state.clients[i].name, name) == 0) {
-            return i;
-        }
+    return names_find(name);
+}
+
+conn_t conn_of_fd(int fd) {
+    if (fd < 0 || fd >= server_state.client_by_fd_size) {
+        return CONN_NONE;
     }
-    return -1;
+    uint32_t generation = __atomic_load_n(&server_state.conn_generation[fd], __ATOMIC_ACQUIRE);
+    return (generation & 1) ? CONN_MAKE(fd, generation) : CONN_NONE;
+}
+
+bool conn_is_live(conn_t conn) {
+    int fd = CONN_FD(conn);
+    if (CONN_IS_NONE(conn) || fd < 0 || fd >= server_state.client_by_fd_size) {
+        return false;
+    }
+    return __atomic_load_n(&server_state.conn_generation[fd], __ATOMIC_ACQUIRE) ==
+           CONN_GENERATION(conn);
 }
 
 int add_client(int fd) {
@@ -365,19 +806,34 @@ int add_client(int fd) {
                   fd, server_state.max_clients);
         return -1;
     }
+    if (fd < 0 || fd >= server_state.client_by_fd_size) {
+        LOG_ERROR("Impossibile aggiungere client FD=%d: oltre l'indice dei client (%d fd)",
+                  fd, server_state.client_by_fd_size);
+        return -2;
+    }
     
-    // Usa num_clients come indice diretto (O(1))
+    // Usa num_clients come indice diretto (O(1)), estendendo la tabella se serve
     int slot = server_state.num_clients;
+    clients_table_fit(slot + 1);
+    server_state.client_by_fd[fd] = slot;
+    // Generazione dispari: nuova connessione sul fd
+    __atomic_store_n(&server_state.conn_generation[fd],
+                     server_state.conn_generation[fd] + 1, __ATOMIC_RELEASE);
     
     // Inizializza il client
     server_state.clients[slot].fd = fd;
-    server_state.clients[slot].name[0] = '\0';
+    server_state.clients_cold[slot].name[0] = '\0';
+    server_state.clients_cold[slot].player_id = PLAYER_NONE;
     server_state.clients[slot].status = CLIENT_CONNECTED;
     server_state.clients[slot].game_index = -1;
     server_state.clients[slot].player_index = -1;
+    publish_client_game(&server_state.clients[slot]);
     
     server_state.num_clients++;
     
+    // Da qui la connessione è sorvegliata dal timer di inattività
+    timers_arm(fd, TIMER_IDLE);
+    
     LOG_INFO("Client aggiunto: FD=%d, slot=%d, totale client=%d", 
              fd, slot, server_state.num_clients);
     
@@ -392,18 +848,37 @@ void remove_client(int fd) {
         return;
     }
     
+    // Il fd sta per essere chiuso: la timer wheel non deve più toccarlo
+    timers_cancel(fd);
+    // Generazione pari: gli handle della connessione non sono più validi
+    // (prima di outbound_close(), vedi outbound_enqueue_conn())
+    __atomic_store_n(&server_state.conn_generation[fd],
+                     server_state.conn_generation[fd] + 1, __ATOMIC_RELEASE);
+    
+    // Il nome torna disponibile (solo i client registrati sono nell'indice)
+    if (server_state.clients[client_idx].status != CLIENT_CONNECTED) {
+        names_remove(server_state.clients_cold[client_idx].name, fd);
+        players_release(server_state.clients_cold[client_idx].player_id);
+    }
+    
     // Swap con l'ultimo client (O(1)) - se non è già l'ultimo
     int last_idx = server_state.num_clients - 1;
     if (client_idx != last_idx) {
         // Copia l'ultimo client nella posizione da rimuovere
         server_state.clients[client_idx] = server_state.clients[last_idx];
+        server_state.clients_cold[client_idx] = server_state.clients_cold[last_idx];
+        server_state.client_by_fd[server_state.clients[client_idx].fd] = client_idx;
         
         LOG_DEBUG("Client swappato: slot %d <- slot %d (FD=%d)", 
                  client_idx, last_idx, server_state.clients[client_idx].fd);
     }
     
-    // Decrementa il contatore
+    // Libera l'ultimo slot e l'indice del fd rimosso, poi decrementa il contatore
+    server_state.clients[last_idx].fd = -1;
+    server_state.client_by_fd[fd] = -1;
+    __atomic_store_n(&server_state.client_game[fd], CLIENT_GAME_NONE, __ATOMIC_RELEASE);
     server_state.num_clients--;
+    clients_table_fit(server_state.num_clients);
 
     LOG_INFO("Rimozione client FD=%d, totale client rimanenti=%d", 
              fd, server_state.num_clients);
@@ -413,93 +888,425 @@ void remove_client(int fd) {
 // FUNZIONI DI GESTIONE PARTITE
 // ============================================================================
 
+/**
+ * Copia di un client per gli handler: campi caldi e nome
+ */
+typedef struct {
+    int fd;
+    conn_t conn;
+    client_status_t status;
+    int game_index;
+    int player_index;
+    player_id_t player_id;
+    char name[MAX_PLAYER_NAME];
+} client_snapshot_t;
+
+/**
+ * Copia lo stato di un client dal registro
+ * 
+ * @param client_fd File descriptor del client
+ * @param client Destinazione della copia
+ * @return true se il client esiste
+ */
+static bool snapshot_client(int client_fd, client_snapshot_t *client) {
+    pthread_mutex_lock(&server_state.clients_lock);
+    int client_idx = find_client_by_fd(client_fd);
+    if (client_idx != -1) {
+        const client_info_t *hot = &server_state.clients[client_idx];
+        client->fd = hot->fd;
+        client->conn = conn_of_fd(hot->fd);
+        client->status = hot->status;
+        client->game_index = hot->game_index;
+        client->player_index = hot->player_index;
+        client->player_id = server_state.clients_cold[client_idx].player_id;
+        memcpy(client->name, server_state.clients_cold[client_idx].name, MAX_PLAYER_NAME);
+    }
+    pthread_mutex_unlock(&server_state.clients_lock);
+    return client_idx != -1;
+}
+
+/**
+ * Istantanea coerente di un client e lock della partita a cui è legato
+ * 
+ * Un client legato a una partita cambia stato solo sotto il lock di quella
+ * partita: acquisito il lock si rilegge il client e, se nel frattempo è
+ * stato spostato su un'altra partita (o su nessuna), si riprova.
+ * 
+ * @param client_fd File descriptor del client
+ * @param client Destinazione dell'istantanea (client->fd = -1 se il client non esiste)
+ * @return Partita con il lock acquisito, o NULL se il client non è legato a partite
+ * @note Da chiamare senza altri lock
+ */
+static game_session_t *lock_client_game(int client_fd, client_snapshot_t *client) {
+    for (;;) {
+        if (!snapshot_client(client_fd, client)) {
+            client->fd = -1;
+            return NULL;
+        }
+        if (client->game_index < 0) {
+            return NULL;
+        }
+        
+        // NULL: segmento già ritirato, quindi la partita è terminata e il client
+        // va riletto (se non è cambiato, lo si tratta come non legato)
+        int game_index = client->game_index;
+        game_session_t *game = lock_game_slot(game_index);
+        if (!game) {
+            if (!snapshot_client(client_fd, client)) {
+                client->fd = -1;
+                return NULL;
+            }
+            if (client->game_index == game_index) {
+                return NULL;
+            }
+            continue;
+        }
+        if (!snapshot_client(client_fd, client)) {
+            unlock_game(game);
+            client->fd = -1;
+            return NULL;
+        }
+        if (client->game_index == (int)(game - server_state.games)) {
+            return game;
+        }
+        unlock_game(game);
+    }
+}
+
+/**
+ * Partita in corso del client, senza passare dal registro dei client
+ * 
+ * La partita si legge da server_state.client_game; sotto il suo lock è la
+ * partita stessa a confermare che il client vi gioca (stessa connessione
+ * nello slot del giocatore, partita iniziata). Con io_mode=actors quel
+ * lock lo prende solo lo shard proprietario: una mossa non tocca lock
+ * condivisi tra shard.
+ * 
+ * @param client_fd File descriptor del client
+ * @param player_index Destinazione dell'indice del giocatore (0 o 1)
+ * @return Partita con il lock acquisito, o NULL se il client non sta giocando
+ */
+static game_session_t *lock_playing_game(int client_fd, int *player_index) {
+    conn_t conn = conn_of_fd(client_fd);
+    if (CONN_IS_NONE(conn)) return NULL;
+    
+    uint64_t ref = __atomic_load_n(&server_state.client_game[client_fd], __ATOMIC_ACQUIRE);
+    int game_index = CLIENT_GAME_INDEX(ref);
+    int index = CLIENT_GAME_PLAYER(ref);
+    if (game_index < 0 || index < 0 || index > 1) return NULL;
+    
+    game_session_t *game = lock_game_slot(game_index);
+    if (!game) return NULL;
+    if (!game->active || GAME_STATUS(&game->state) != GAME_IN_PROGRESS ||
+        !CONN_EQUAL(game->player_conns[index], conn)) {
+        unlock_game(game);
+        return NULL;
+    }
+    *player_index = index;
+    return game;
+}
+
+/**
+ * Indice nel registro del client di una connessione, -1 se è stata chiusa
+ * 
+ * @note Richiede che server_state.clients_lock sia già acquisito
+ */
+static int find_client_by_conn(conn_t conn) {
+    if (!conn_is_live(conn)) return -1;
+    return find_client_by_fd(CONN_FD(conn));
+}
+
+/**
+ * Aggiorna stato e partita di un client nel registro
+ * 
+ * Non fa nulla se la connessione è stata chiusa nel frattempo.
+ * 
+ * @note Richiede il lock della partita coinvolta (vecchia o nuova), se presente
+ */
+static void set_client_game(conn_t conn, client_status_t status, int game_index, int player_index) {
+    pthread_mutex_lock(&server_state.clients_lock);
+    int client_idx = find_client_by_conn(conn);
+    if (client_idx != -1) {
+        client_info_t *client = &server_state.clients[client_idx];
+        client->status = status;
+        client->game_index = game_index;
+        client->player_index = player_index;
+        publish_client_game(client);
+        timers_watch_idle(client->fd, idle_watched(game_index));
+    }
+    pthread_mutex_unlock(&server_state.clients_lock);
+}
+
+/**
+ * Riporta a CLIENT_REGISTERED un client ancora legato alla partita 'slot'
+ * 
+ * @note Richiede il lock della partita e server_state.clients_lock
+ */
+static void release_client_from_game(conn_t conn, int slot) {
+    int client_idx = find_client_by_conn(conn);
+    if (client_idx == -1) return;
+    
+    client_info_t *client = &server_state.clients[client_idx];
+    if (client->game_index != slot) return;
+    client->game_index = -1;
+    client->player_index = -1;
+    client->status = CLIENT_REGISTERED;
+    publish_client_game(client);
+    timers_watch_idle(client->fd, true);
+}
+
+// Valore di 'digits' cifre esadecimali maiuscole, -1 se il testo non è valido
+static int64_t parse_hex_field(const char *text, int digits) {
+    int64_t value = 0;
+    for (int i = 0; i < digits; i++) {
+        char c = text[i];
+        int digit;
+        if (c >= '0' && c <= '9') digit = c - '0';
+        else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+        else return -1;
+        value = (value << 4) | digit;
+    }
+    return value;
+}
+
+/**
+ * Decodifica slot e generazione di un game_id, senza guardare le partite
+ * 
+ * @return Slot codificato, o -1 se il game_id non è ben formato
+ */
+static int game_id_slot(const char *game_id, int64_t *generation) {
+    if (!game_id || game_id[0] != 'G' ||
+        strnlen(game_id, MAX_GAME_ID_LEN) != 1 + GAME_ID_SLOT_DIGITS + GAME_ID_GEN_DIGITS) {
+        return -1;
+    }
+    int64_t slot = parse_hex_field(game_id + 1, GAME_ID_SLOT_DIGITS);
+    *generation = parse_hex_field(game_id + 1 + GAME_ID_SLOT_DIGITS, GAME_ID_GEN_DIGITS);
+    if (slot < 0 || *generation <= 0 || slot >= server_state.max_games) {
+        return -1;
+    }
+    return (int)slot;
+}
+
 int find_game_by_id(const char *game_id) {
-    if (!game_id) return -1;
+    // Decodifica slot e generazione: nessuna scansione delle partite
+    int64_t generation;
+    int slot = game_id_slot(game_id, &generation);
+    if (slot < 0) {
+        return -1;
+    }
     
-    for (int i = 0; i < server_state.max_games; i++) {
-        if (server_state.games[i].active && 
-            strcmp(server_state.games[i].state.game_id, game_id) == 0) {
-            return i;
-        }
+    // Uno slot riutilizzato ha una generazione diversa: l'ID vecchio non è più valido
+    game_session_t *game = lock_game_slot(slot);
+    if (!game) {
+        return -1;
     }
-    return -1;
+    if (!game->active || game->generation != (uint32_t)generation) {
+        unlock_game(game);
+        return -1;
+    }
+    return slot;
+}
+
+// Scrive 'value' in 'digits' cifre esadecimali maiuscole (inverso di parse_hex_field())
+static void format_hex_field(char *text, uint32_t value, int digits) {
+    static const char hex[] = "0123456789ABCDEF";
+    for (int i = digits - 1; i >= 0; i--) {
+        text[i] = hex[value & 0xF];
+        value >>= 4;
+    }
+}
+
+void game_session_id(const game_session_t *game, char game_id[MAX_GAME_ID_LEN]) {
+    uint32_t slot = (uint32_t)(game - server_state.games);
+    game_id[0] = 'G';
+    format_hex_field(game_id + 1, slot & (GAME_ID_MAX_SLOTS - 1), GAME_ID_SLOT_DIGITS);
+    format_hex_field(game_id + 1 + GAME_ID_SLOT_DIGITS, game->generation, GAME_ID_GEN_DIGITS);
+    game_id[1 + GAME_ID_SLOT_DIGITS + GAME_ID_GEN_DIGITS] = '\0';
+}
+
+int message_target_game(int client_fd, const protocol_header_t *header, const void *payload) {
+    // Il join tocca la partita richiesta, non quella (eventuale) del client
+    if (header && header->msg_type == MSG_JOIN_GAME) {
+        if (!payload || header->length < sizeof(payload_join_game_t)) return -1;
+        int64_t generation;
+        return game_id_slot(((const payload_join_game_t*)payload)->game_id, &generation);
+    }
+    
+    // Copia senza lock: il messaggio viene instradato senza passare dal registro
+    if (client_fd < 0 || client_fd >= server_state.client_by_fd_size) return -1;
+    return CLIENT_GAME_INDEX(__atomic_load_n(&server_state.client_game[client_fd], __ATOMIC_ACQUIRE));
 }
 
 int find_game_by_client_fd(int fd) { //NOTE: not used
-    for (int i = 0; i < server_state.max_games; i++) {
-        if (server_state.games[i].active &&
-            (server_state.games[i].player_fds[0] == fd ||
-             server_state.games[i].player_fds[1] == fd)) {
+    int capacity = games_table_capacity();
+    for (int i = 0; i < capacity; i++) {
+        game_session_t *game = lock_game_slot(i);
+        if (!game) break;
+        bool found = game->active && ((!CONN_IS_NONE(game->player_conns[0]) &&
+                                       CONN_FD(game->player_conns[0]) == fd) ||
+                                      (!CONN_IS_NONE(game->player_conns[1]) &&
+                                       CONN_FD(game->player_conns[1]) == fd));
+        unlock_game(game);
+        if (found) {
             return i;
         }
     }
     return -1;
 }
 
-int create_game(const char *creator_name, int creator_fd) {
-    if (!creator_name) return -1;
+/**
+ * Accoda una partita appena creata alla lista di attesa (O(1))
+ * 
+ * @note Richiede che server_state.lobby_lock sia già acquisito
+ */
+static void waiting_list_append(int slot) {
+    game_session_t *game = &server_state.games[slot];
+    if (game->waiting) return;
+    
+    game->wait_prev = server_state.waiting_tail;
+    game->wait_next = -1;
+    if (server_state.waiting_tail != -1) {
+        server_state.games[server_state.waiting_tail].wait_next = slot;
+    } else {
+        server_state.waiting_head = slot;
+    }
+    server_state.waiting_tail = slot;
+    game->waiting = 1;
+    server_state.num_waiting++;
+    lobby_publish();
+}
+
+/**
+ * Toglie una partita dalla lista di attesa (O(1), nulla se non collegata)
+ * 
+ * @note Richiede che server_state.lobby_lock sia già acquisito
+ */
+static void waiting_list_remove(int slot) {
+    game_session_t *game = &server_state.games[slot];
+    if (!game->waiting) return;
+    
+    if (game->wait_prev != -1) {
+        server_state.games[game->wait_prev].wait_next = game->wait_next;
+    } else {
+        server_state.waiting_head = game->wait_next;
+    }
+    if (game->wait_next != -1) {
+        server_state.games[game->wait_next].wait_prev = game->wait_prev;
+    } else {
+        server_state.waiting_tail = game->wait_prev;
+    }
+    game->wait_prev = game->wait_next = -1;
+    game->waiting = 0;
+    server_state.num_waiting--;
+    lobby_publish();
+}
+
+int create_game(player_id_t creator, conn_t creator_conn) {
+    if (creator == PLAYER_NONE) return -1;
     
-    // Trova uno slot libero
-    for (int i = 0; i < server_state.max_games; i++) {
-        if (!server_state.games[i].active) {
-            game_session_t *game = &server_state.games[i];
-            
-            // Genera un game_id univoco usando timestamp + indice //NOTE: c'è un modo più semplice?
-            char game_id[MAX_GAME_ID_LEN];
-            snprintf(game_id, MAX_GAME_ID_LEN, "G%06ld%02d", time(NULL) % 1000000, i % 100);
-            
-            // Inizializza il game state (da game_logic.h)
-            game_init(&game->state, game_id, creator_name);
-            
-            // Imposta i FD dei giocatori
-            game->player_fds[0] = creator_fd;
-            game->player_fds[1] = -1;  // Ancora nessun secondo giocatore
-            
-            // Nessun pending join inizialmente
-            game->pending_join_fd = -1;
-            game->pending_join_name[0] = '\0';
-            
-            // Marca come attiva
-            game->active = 1;
-            server_state.num_games++;
-            
-            LOG_INFO("Partita creata: game_id='%s', creatore='%s', FD=%d, slot=%d, totale partite=%d",
-                     game_id, creator_name, creator_fd, i, server_state.num_games);
-            
-            return i;
-        }
+    // Preleva uno slot dal segmento più basso con posti liberi (la tabella cresce se serve)
+    pthread_mutex_lock(&server_state.lobby_lock);
+    int i = games_table_alloc();
+    if (i == -1) {
+        pthread_mutex_unlock(&server_state.lobby_lock);
+        LOG_ERROR("Impossibile creare partita: tabella piena (max_games=%d)", server_state.max_games);
+        return -1;
     }
     
-    LOG_ERROR("Impossibile creare partita: array pieno (max_games=%d)", server_state.max_games);
-    return -1;
+    // Generazione del nuovo game_id (mai 0, ciclo dopo 2^32 partite)
+    if (++last_game_generation == 0) last_game_generation = 1;
+    uint32_t generation = last_game_generation;
+    pthread_mutex_unlock(&server_state.lobby_lock);
+    
+    // Fuori dalla lista libera lo slot è solo nostro (e il suo segmento non può essere
+    // ritirato): lo si inizializza sotto il suo lock
+    game_session_t *game = lock_game_slot(i);
+    if (!game) {
+        // Record di lettura non allocabile: lo slot torna tra i liberi
+        pthread_mutex_lock(&server_state.lobby_lock);
+        games_table_free(i);
+        pthread_mutex_unlock(&server_state.lobby_lock);
+        LOG_ERROR("Impossibile creare partita: slot %d non acquisibile", i);
+        return -1;
+    }
+    // Il game_id univoco deriva da slot e generazione
+    game->generation = generation;
+    char game_id[MAX_GAME_ID_LEN];
+    game_session_id(game, game_id);
+    
+    // Inizializza il game state (da game_logic.h): la partita tiene un riferimento al creatore
+    players_ref(creator);
+    game_init(&game->state, creator);
+    
+    // Imposta le connessioni dei giocatori
+    game->player_conns[0] = creator_conn;
+    game->player_conns[1] = CONN_NONE;  // Ancora nessun secondo giocatore
+    
+    // Nessun pending join inizialmente
+    game->pending_join_conn = CONN_NONE;
+    game->pending_join_id = PLAYER_NONE;
+    
+    // Marca come attiva; in lobby solo dopo l'inizializzazione completa
+    game->active = 1;
+    pthread_mutex_lock(&server_state.lobby_lock);
+    server_state.num_games++;
+    waiting_list_append(i);
+    int total_games = server_state.num_games;
+    pthread_mutex_unlock(&server_state.lobby_lock);
+    
+    LOG_INFO("Partita creata: game_id='%s', creatore='%s', FD=%d, slot=%d, totale partite=%d",
+             game_id, players_name(creator), CONN_FD(creator_conn), i, total_games);
+    
+    return i;
 }
 
 void cleanup_game(game_session_t *game) {
     if (!game || !game->active) return;
     
-    LOG_INFO("Cleanup partita: game_id='%s'", game->state.game_id);
+    char game_id[MAX_GAME_ID_LEN];
+    game_session_id(game, game_id);
+    LOG_INFO("Cleanup partita: game_id='%s'", game_id);
+    int slot = (int)(game - server_state.games);
+    conn_t joiner = game->pending_join_conn;
     
     // Trova i client associati e resetta il loro stato
+    pthread_mutex_lock(&server_state.clients_lock);
     for (int i = 0; i < 2; i++) {
-        if (game->player_fds[i] > 0) {
-            int client_idx = find_client_by_fd(game->player_fds[i]);
-            if (client_idx != -1) {
-                client_info_t *client = &server_state.clients[client_idx];
-                client->game_index = -1;
-                client->player_index = -1;
-                client->status = CLIENT_REGISTERED;
-                LOG_DEBUG("Client FD=%d rimosso dalla partita, status -> REGISTERED", 
-                         client->fd);
-            }
+        if (!CONN_IS_NONE(game->player_conns[i])) {
+            release_client_from_game(game->player_conns[i], slot);
+            LOG_DEBUG("Client FD=%d rimosso dalla partita, status -> REGISTERED", 
+                     CONN_FD(game->player_conns[i]));
         }
     }
+    // Una richiesta di join ancora pendente viene rifiutata
+    if (!CONN_IS_NONE(joiner)) {
+        release_client_from_game(joiner, slot);
+    }
+    pthread_mutex_unlock(&server_state.clients_lock);
+    
+    if (!CONN_IS_NONE(joiner)) {
+        notify_join_response(joiner, game_id, 0);
+    }
     
-    // Marca la partita come non attiva
+    // Marca la partita come non attiva e rimette lo slot tra i liberi del suo segmento
     game->active = 0;
-    game->pending_join_fd = -1;
+    game->pending_join_conn = CONN_NONE;
+    
+    pthread_mutex_lock(&server_state.lobby_lock);
+    waiting_list_remove(slot);
+    games_table_free(slot);
     server_state.num_games--;
+    int remaining = server_state.num_games;
+    pthread_mutex_unlock(&server_state.lobby_lock);
     
-    LOG_INFO("Partita pulita, totale partite rimanenti=%d", server_state.num_games);
+    // Fuori dalla lista di attesa lo snapshot della lobby non legge più i nomi dei giocatori
+    players_release(game->state.players[0]);
+    players_release(game->state.players[1]);
+    players_release(game->pending_join_id);
+    game->state.players[0] = game->state.players[1] = PLAYER_NONE;
+    game->pending_join_id = PLAYER_NONE;
+    
+    LOG_INFO("Partita pulita, totale partite rimanenti=%d", remaining);
 }
 
 // ============================================================================
@@ -513,25 +1320,26 @@ void handle_register(int client_fd, const void *payload, uint16_t length) {
     response.status = STATUS_ERROR;
     response.error_code = ERR_INTERNAL;
     
-    pthread_mutex_lock(&server_state.mutex);
+    pthread_mutex_lock(&server_state.clients_lock);
     
     // Trova il client
     int client_idx = find_client_by_fd(client_fd);
     if (client_idx == -1) {
         LOG_ERROR("Client FD=%d non trovato in handle_register", client_fd);
-        pthread_mutex_unlock(&server_state.mutex);
-        protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+        pthread_mutex_unlock(&server_state.clients_lock);
+        send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
         return;
     }
     
     client_info_t *client = &server_state.clients[client_idx];
+    char *client_name = server_state.clients_cold[client_idx].name;
     
     // Controlla se è già registrato
     if (client->status != CLIENT_CONNECTED) {
-        LOG_WARN("Client FD=%d già registrato con nome '%s'", client_fd, client->name);
+        LOG_WARN("Client FD=%d già registrato con nome '%s'", client_fd, client_name);
         response.error_code = ERR_ALREADY_REGISTERED;  
-        pthread_mutex_unlock(&server_state.mutex);
-        protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+        pthread_mutex_unlock(&server_state.clients_lock);
+        send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
         return;
     }
     
@@ -540,8 +1348,8 @@ void handle_register(int client_fd, const void *payload, uint16_t length) {
         LOG_ERROR("Payload MSG_REGISTER invalido: length=%d, expected=%zu", 
                  length, sizeof(payload_register_t));
         response.error_code = ERR_INVALID_PAYLOAD;
-        pthread_mutex_unlock(&server_state.mutex);
-        protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+        pthread_mutex_unlock(&server_state.clients_lock);
+        send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
         return;
     }
     
@@ -551,8 +1359,8 @@ void handle_register(int client_fd, const void *payload, uint16_t length) {
     if (!protocol_validate_name(reg->player_name)) {
         LOG_WARN("Nome giocatore non valido: '%s'", reg->player_name);
         response.error_code = ERR_INVALID_NAME;
-        pthread_mutex_unlock(&server_state.mutex);
-        protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+        pthread_mutex_unlock(&server_state.clients_lock);
+        send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
         return;
     }
     
@@ -560,24 +1368,40 @@ void handle_register(int client_fd, const void *payload, uint16_t length) {
     if (find_client_by_name(reg->player_name) != -1) {
         LOG_WARN("Nome '%s' già in uso", reg->player_name);
         response.error_code = ERR_NAME_TAKEN;
-        pthread_mutex_unlock(&server_state.mutex);
-        protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+        pthread_mutex_unlock(&server_state.clients_lock);
+        send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
         return;
     }
     
-    // Registra il client
-    strncpy(client->name, reg->player_name, MAX_PLAYER_NAME - 1);
-    client->name[MAX_PLAYER_NAME - 1] = '\0';
+    // Registra il client: le partite lo indicano con l'ID del nome internato
+    player_id_t player_id = players_add(reg->player_name);
+    if (player_id == PLAYER_NONE) {
+        response.error_code = ERR_SERVER_FULL;
+        pthread_mutex_unlock(&server_state.clients_lock);
+        send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
+        return;
+    }
+    strncpy(client_name, reg->player_name, MAX_PLAYER_NAME - 1);
+    client_name[MAX_PLAYER_NAME - 1] = '\0';
+    if (names_insert(client_name, client_fd) < 0) {
+        client_name[0] = '\0';
+        players_release(player_id);
+        response.error_code = ERR_INTERNAL;
+        pthread_mutex_unlock(&server_state.clients_lock);
+        send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
+        return;
+    }
+    server_state.clients_cold[client_idx].player_id = player_id;
     client->status = CLIENT_REGISTERED;
     
-    LOG_INFO("Client FD=%d registrato con nome '%s'", client_fd, client->name);
+    LOG_INFO("Client FD=%d registrato con nome '%s'", client_fd, client_name);
     
-    pthread_mutex_unlock(&server_state.mutex);
+    pthread_mutex_unlock(&server_state.clients_lock);
     
     // Invia risposta di successo
     response.status = STATUS_OK;
     response.error_code = ERR_NONE;
-    protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+    send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
 }
 
 void handle_create_game(int client_fd) {
@@ -588,157 +1412,100 @@ void handle_create_game(int client_fd) {
     response.error_code = ERR_INTERNAL;
     response.game_id[0] = '\0';
     
-    pthread_mutex_lock(&server_state.mutex);
-    
-    // Trova il client
-    int client_idx = find_client_by_fd(client_fd);
-    if (client_idx == -1) {
+    // Un client registrato non è legato a partite: solo questo thread ne cambia lo stato
+    client_snapshot_t client;
+    if (!snapshot_client(client_fd, &client)) {
         LOG_ERROR("Client FD=%d non trovato in handle_create_game", client_fd);
-        pthread_mutex_unlock(&server_state.mutex);
-        protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+        send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
         return;
     }
     
-    client_info_t *client = &server_state.clients[client_idx];
-    
     // Deve essere registrato
-    if (client->status != CLIENT_REGISTERED) {
+    if (client.status != CLIENT_REGISTERED) {
         LOG_WARN("Client FD=%d non registrato o già in partita (status=%d)", 
-                 client_fd, client->status);
-        response.error_code = (client->status == CLIENT_CONNECTED) ? 
+                 client_fd, client.status);
+        response.error_code = (client.status == CLIENT_CONNECTED) ? 
                              ERR_NOT_REGISTERED : ERR_ALREADY_IN_GAME;
-        pthread_mutex_unlock(&server_state.mutex);
-        protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+        send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
         return;
     }
     
-    // Crea la partita
-    int game_index = create_game(client->name, client_fd);
+    // Crea la partita (restituita con il suo lock acquisito)
+    int game_index = create_game(client.player_id, client.conn);
     if (game_index == -1) {
         LOG_ERROR("Impossibile creare partita per client FD=%d", client_fd);
         response.error_code = ERR_SERVER_FULL;
-        pthread_mutex_unlock(&server_state.mutex);
-        protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+        send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
         return;
     }
     
-    game_state_t *game = &server_state.games[game_index].state;
+    game_session_t *session = &server_state.games[game_index];
     
-    // Aggiorna lo stato del client
-    client->game_index = game_index;
-    client->player_index = 0;  // Il creatore è sempre player 0
-    client->status = CLIENT_IN_LOBBY;  // In attesa che qualcuno faccia join
-    
-    LOG_INFO("Partita '%s' creata da client '%s' (FD=%d)", 
-             game->game_id, client->name, client_fd);
+    // Aggiorna lo stato del client: il creatore è sempre player 0, in attesa di join
+    set_client_game(client.conn, CLIENT_IN_LOBBY, game_index, 0);
     
     // Prepara risposta di successo
     response.status = STATUS_OK;
     response.error_code = ERR_NONE;
-    strncpy(response.game_id, game->game_id, MAX_GAME_ID_LEN - 1);
-    response.game_id[MAX_GAME_ID_LEN - 1] = '\0';
+    game_session_id(session, response.game_id);
+    
+    LOG_INFO("Partita '%s' creata da client '%s' (FD=%d)", 
+             response.game_id, client.name, client_fd);
     
     // Prepara notifica broadcast
     notify_game_created_t notify;
     notify.notify_type = NOTIFY_GAME_CREATED;
-    strncpy(notify.game_id, game->game_id, MAX_GAME_ID_LEN - 1);
-    notify.game_id[MAX_GAME_ID_LEN - 1] = '\0';
-    strncpy(notify.creator, client->name, MAX_PLAYER_NAME - 1);
+    memcpy(notify.game_id, response.game_id, MAX_GAME_ID_LEN);
+    strncpy(notify.creator, client.name, MAX_PLAYER_NAME - 1);
     notify.creator[MAX_PLAYER_NAME - 1] = '\0';
     
-    pthread_mutex_unlock(&server_state.mutex);
+    unlock_game(session);
     
     // Invia risposta al creatore
-    protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+    send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
     
     // Broadcast ai client registrati
-    pthread_mutex_lock(&server_state.mutex);
+    pthread_mutex_lock(&server_state.clients_lock);
     broadcast_to_registered_clients(MSG_NOTIFY, &notify, sizeof(notify));
-    pthread_mutex_unlock(&server_state.mutex);
+    pthread_mutex_unlock(&server_state.clients_lock);
     
-    LOG_INFO("Broadcast GAME_CREATED inviato per partita '%s'", game->game_id);
+    LOG_INFO("Broadcast GAME_CREATED inviato per partita '%s'", notify.game_id);
 }
 
 void handle_list_games(int client_fd) {
     LOG_DEBUG("handle_list_games chiamato da FD=%d", client_fd);
     
-    pthread_mutex_lock(&server_state.mutex);
-
     // Trova il client
-    int client_idx = find_client_by_fd(client_fd);
-    if (client_idx == -1) {
+    client_snapshot_t client;
+    if (!snapshot_client(client_fd, &client)) {
         LOG_ERROR("Client FD=%d non trovato in handle_list_games", client_fd);
-        pthread_mutex_unlock(&server_state.mutex);
         send_list_games_error(client_fd, ERR_INTERNAL);
         return;
     }
 
-    client_info_t *client = &server_state.clients[client_idx];
-
     // Controlla se è registrato
-    if (client->status != CLIENT_REGISTERED && client->status != CLIENT_REQUESTING_JOIN) {
+    if (client.status != CLIENT_REGISTERED && client.status != CLIENT_REQUESTING_JOIN) {
         LOG_WARN("Client FD=%d non registrato o già in partita (status=%d)", 
-                 client_fd, client->status);
-        error_code_t error = (client->status == CLIENT_CONNECTED) ? 
+                 client_fd, client.status);
+        error_code_t error = (client.status == CLIENT_CONNECTED) ? 
                              ERR_NOT_REGISTERED : ERR_ALREADY_IN_GAME;
-        pthread_mutex_unlock(&server_state.mutex);
         send_list_games_error(client_fd, error);
         return;
     }
 
-    // Conta partite in attesa (GAME_WAITING)
-    int waiting_count = 0;
-    for (int i = 0; i < server_state.max_games; i++) {
-        if (server_state.games[i].active && 
-            server_state.games[i].state.status == GAME_WAITING) {
-            waiting_count++;
-        }
+    // Nessun lock: la lista è quella dell'ultima versione pubblicata
+    const lobby_snapshot_t *snapshot = lobby_acquire();
+    if (snapshot->waiting > MAX_LISTED_GAMES) {
+        LOG_WARN("Lista partite per FD=%d troncata: %d partite in attesa, massimo %d",
+                 client_fd, snapshot->waiting, MAX_LISTED_GAMES);
     }
     
-    // Calcola dimensione risposta
-    size_t response_size = sizeof(response_list_games_t) + (waiting_count * sizeof(game_info_t));
-    uint8_t *response_buffer = malloc(response_size);
-    if (!response_buffer) {
-        LOG_ERROR("Errore allocazione memoria per list_games");
-        pthread_mutex_unlock(&server_state.mutex);
-        send_list_games_error(client_fd, ERR_INTERNAL);
-        return;
-    }
-    
-    // Prepara risposta
-    response_list_games_t *response = (response_list_games_t*)response_buffer;
-    response->status = STATUS_OK;
-    response->error_code = ERR_NONE;
-    response->game_count = waiting_count;
-    response->reserved = 0;
-    
-    // Riempi array partite     // Aritmetica dei puntatori
-    game_info_t *games_array = (game_info_t*)(response_buffer + sizeof(response_list_games_t));
-    int idx = 0;
-    for (int i = 0; i < server_state.max_games && idx < waiting_count; i++) {
-        if (server_state.games[i].active && 
-            server_state.games[i].state.status == GAME_WAITING) {
-            
-            strncpy(games_array[idx].game_id, server_state.games[i].state.game_id, MAX_GAME_ID_LEN - 1);
-            games_array[idx].game_id[MAX_GAME_ID_LEN - 1] = '\0';
-            
-            strncpy(games_array[idx].creator, server_state.games[i].state.players[0], MAX_PLAYER_NAME - 1);
-            games_array[idx].creator[MAX_PLAYER_NAME - 1] = '\0';
-            
-            games_array[idx].status = GAME_WAITING; // Conosco per certo lo status
-            games_array[idx].players_count = 1;  // Solo il creatore
-            
-            idx++;
-        }
-    }
+    LOG_INFO("Lista partite per FD=%d: %d partite in attesa (versione %llu)",
+             client_fd, snapshot->waiting, (unsigned long long)snapshot->version);
     
-    LOG_INFO("Lista partite per FD=%d: %d partite in attesa", client_fd, waiting_count);
-    
-    pthread_mutex_unlock(&server_state.mutex);
-    
-    // Invia risposta
-    protocol_send(client_fd, MSG_RESPONSE, response_buffer, response_size, 0);
-    free(response_buffer);
+    // send_to_client copia il payload nella coda di uscita: dopo si può rilasciare
+    send_to_client(client_fd, MSG_RESPONSE, snapshot->data, snapshot->size);
+    lobby_release(snapshot);
 }
 
 void handle_join_game(int client_fd, const void *payload, uint16_t length) {
@@ -751,97 +1518,88 @@ void handle_join_game(int client_fd, const void *payload, uint16_t length) {
     response.opponent[0] = '\0';
     response.game_id[0] = '\0';
     
-    pthread_mutex_lock(&server_state.mutex);
-    
     // Trova il client
-    int client_idx = find_client_by_fd(client_fd);
-    if (client_idx == -1) {
+    client_snapshot_t client;
+    if (!snapshot_client(client_fd, &client)) {
         LOG_WARN("Client FD=%d non trovato", client_fd);
         response.error_code = ERR_INTERNAL;
-        pthread_mutex_unlock(&server_state.mutex);
-        protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+        send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
         return;
     }
-    
-    client_info_t *client = &server_state.clients[client_idx];
 
     // Deve essere registrato
-    if (client->status != CLIENT_REGISTERED) {
+    if (client.status != CLIENT_REGISTERED) {
         LOG_WARN("Client FD=%d non registrato o già in partita", client_fd);
-        response.error_code = (client->status == CLIENT_IN_GAME) ? 
+        response.error_code = (client.status == CLIENT_IN_GAME) ? 
                              ERR_ALREADY_IN_GAME : ERR_INTERNAL;
-        pthread_mutex_unlock(&server_state.mutex);
-        protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+        send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
         return;
     }
     
     // Valida payload
     if (length < sizeof(payload_join_game_t)) {
         LOG_ERROR("Payload MSG_JOIN_GAME invalido");
-        pthread_mutex_unlock(&server_state.mutex);
-        protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+        send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
         return;
     }
     
     const payload_join_game_t *join_req = (const payload_join_game_t*)payload;
     
-    // Trova la partita
+    // Trova la partita (restituita con il suo lock acquisito)
     int game_idx = find_game_by_id(join_req->game_id);
     if (game_idx == -1) {
         LOG_WARN("Partita '%s' non trovata", join_req->game_id);
         response.error_code = ERR_GAME_NOT_FOUND;
-        pthread_mutex_unlock(&server_state.mutex);
-        protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+        send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
         return;
     }
     
     game_session_t *game = &server_state.games[game_idx];
     
     // Controlla se è in attesa
-    if (game->state.status != GAME_WAITING) {
-        LOG_WARN("Partita '%s' non in attesa (status=%d)", join_req->game_id, game->state.status);
+    if (GAME_STATUS(&game->state) != GAME_WAITING) {
+        LOG_WARN("Partita '%s' non in attesa (status=%d)", join_req->game_id,
+                 GAME_STATUS(&game->state));
         response.error_code = ERR_GAME_FULL;
-        pthread_mutex_unlock(&server_state.mutex);
-        protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+        unlock_game(game);
+        send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
         return;
     }
 
     // Controlla se c'è già una richiesta pendente
-    if (game->pending_join_fd > 0) {
+    if (!CONN_IS_NONE(game->pending_join_conn)) {
         LOG_WARN("Partita '%s' ha già una richiesta pendente", join_req->game_id);
         response.error_code = ERR_PENDING_JOIN_EXISTS;  
-        pthread_mutex_unlock(&server_state.mutex);
-        protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+        unlock_game(game);
+        send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
         return;
     }
     
     // Salva pending join
-    game->pending_join_fd = client_fd;
-    strncpy(game->pending_join_name, client->name, MAX_PLAYER_NAME - 1);
-    game->pending_join_name[MAX_PLAYER_NAME - 1] = '\0';
-    
-    // Aggiorna stato client
-    client->status = CLIENT_REQUESTING_JOIN;
+    game->pending_join_conn = client.conn;
+    players_ref(client.player_id);
+    game->pending_join_id = client.player_id;
     
-    LOG_INFO("Client '%s' (FD=%d) vuole joinare partita '%s', in attesa di accept",
-             client->name, client_fd, game->state.game_id);
+    // Aggiorna stato client: legato alla partita richiesta fino alla risposta del creatore
+    set_client_game(client.conn, CLIENT_REQUESTING_JOIN, game_idx, -1);
     
     // Invia risposta OK al joiner
     response.status = STATUS_OK;
     response.error_code = ERR_NONE;
-    strncpy(response.opponent, game->state.players[0], MAX_PLAYER_NAME - 1);
+    strncpy(response.opponent, players_name(game->state.players[0]), MAX_PLAYER_NAME - 1);
     response.opponent[MAX_PLAYER_NAME - 1] = '\0';
-    strncpy(response.game_id, game->state.game_id, MAX_GAME_ID_LEN - 1);
-    response.game_id[MAX_GAME_ID_LEN - 1] = '\0';
+    game_session_id(game, response.game_id);
     
-    pthread_mutex_unlock(&server_state.mutex);
+    LOG_INFO("Client '%s' (FD=%d) vuole joinare partita '%s', in attesa di accept",
+             client.name, client_fd, response.game_id);
+    conn_t creator = game->player_conns[0];
+    
+    unlock_game(game);
     
-    protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+    send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
     
     // Notifica al creatore
-    pthread_mutex_lock(&server_state.mutex);
-    notify_join_request(game->player_fds[0], client->name);
-    pthread_mutex_unlock(&server_state.mutex);
+    notify_join_request(creator, client.name);
 }
 
 void handle_accept_join(int client_fd, const void *payload, uint16_t length) {
@@ -851,117 +1609,101 @@ void handle_accept_join(int client_fd, const void *payload, uint16_t length) {
     response.status = STATUS_ERROR;
     response.error_code = ERR_INTERNAL;
     
-    pthread_mutex_lock(&server_state.mutex);
-    
-    // Trova il client (creatore della partita)
-    int client_idx = find_client_by_fd(client_fd);
-    if (client_idx == -1) {
+    // Trova il client (creatore della partita) e blocca la sua partita
+    client_snapshot_t client;
+    game_session_t *game = lock_client_game(client_fd, &client);
+    if (client.fd == -1) {
         LOG_WARN("Client FD=%d non trovato", client_fd);
-        pthread_mutex_unlock(&server_state.mutex);
-        protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+        send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
         return;
     }
-    
-    client_info_t *client = &server_state.clients[client_idx];
 
     // Deve essere in lobby
-    if (client->status != CLIENT_IN_LOBBY) {
+    if (!game || client.status != CLIENT_IN_LOBBY) {
         LOG_WARN("Client FD=%d non in lobby", client_fd);
         response.error_code = ERR_NOT_IN_LOBBY;
-        pthread_mutex_unlock(&server_state.mutex);
-        protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+        if (game) unlock_game(game);
+        send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
         return;
     }
     
-    game_session_t *game = &server_state.games[client->game_index];
-
+    char game_id[MAX_GAME_ID_LEN];
+    game_session_id(game, game_id);
+    
     // Controlla pending join
-    if (!game->active || game->pending_join_fd <= 0) {
-        LOG_WARN("Nessuna richiesta di join pendente per partita '%s'", game->state.game_id);
+    if (!game->active || CONN_IS_NONE(game->pending_join_conn)) {
+        LOG_WARN("Nessuna richiesta di join pendente per partita '%s'", game_id);
         response.error_code = ERR_NO_PENDING_JOIN;
-        pthread_mutex_unlock(&server_state.mutex);
-        protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+        unlock_game(game);
+        send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
         return;
     }
     
     // Valida payload
     if (length < sizeof(payload_accept_join_t)) {
         LOG_ERROR("Payload MSG_ACCEPT_JOIN invalido");
-        pthread_mutex_unlock(&server_state.mutex);
-        protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+        unlock_game(game);
+        send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
         return;
     }
     
     const payload_accept_join_t *accept_req = (const payload_accept_join_t*)payload;
-    int joiner_fd = game->pending_join_fd;
-    char joiner_name[MAX_PLAYER_NAME];
-    strncpy(joiner_name, game->pending_join_name, MAX_PLAYER_NAME - 1);
-    joiner_name[MAX_PLAYER_NAME - 1] = '\0';
+    conn_t joiner = game->pending_join_conn;
     
     if (accept_req->accept == 1) {
-        // ACCETTA: aggiungi secondo giocatore
-        if (game_add_player(&game->state, joiner_name)) {
-            game->player_fds[1] = joiner_fd;
+        // ACCETTA: aggiungi secondo giocatore (il riferimento del join pendente passa a lui)
+        if (game_add_player(&game->state, game->pending_join_id)) {
+            game->player_conns[1] = joiner;
             
-            // Aggiorna stato joiner
-            int joiner_idx = find_client_by_fd(joiner_fd);
-            if (joiner_idx != -1) {
-                client_info_t *joiner = &server_state.clients[joiner_idx];
-                joiner->game_index = client->game_index;
-                joiner->player_index = 1;
-                joiner->status = CLIENT_IN_GAME;
-            }
+            // La partita non è più in attesa
+            pthread_mutex_lock(&server_state.lobby_lock);
+            waiting_list_remove(client.game_index);
+            pthread_mutex_unlock(&server_state.lobby_lock);
             
-            // Aggiorna stato creatore (da IN_LOBBY a IN_GAME)
-            client->status = CLIENT_IN_GAME;
+            // Aggiorna stato joiner e creatore (da IN_LOBBY a IN_GAME)
+            set_client_game(joiner, CLIENT_IN_GAME, client.game_index, 1);
+            set_client_game(client.conn, CLIENT_IN_GAME, client.game_index, 0);
             
-            LOG_INFO("Join accettato: partita '%s' ora con 2 giocatori", game->state.game_id);
+            LOG_INFO("Join accettato: partita '%s' ora con 2 giocatori", game_id);
             
             // Pulisci pending join
-            game->pending_join_fd = -1;
-            
-            pthread_mutex_unlock(&server_state.mutex);
+            game->pending_join_conn = CONN_NONE;
+            game->pending_join_id = PLAYER_NONE;
             
             // Invia risposte
             response.status = STATUS_OK;
             response.error_code = ERR_NONE;
-            protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+            send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
             
             // Notifica al joiner: accettato
-            pthread_mutex_lock(&server_state.mutex);
-            notify_join_response(joiner_fd, game->state.game_id, 1);
+            notify_join_response(joiner, game_id, 1);
             
             // Notifica inizio partita a entrambi
             notify_game_start(game);
-            pthread_mutex_unlock(&server_state.mutex);
+            unlock_game(game);
         } else {
             LOG_ERROR("Errore aggiunta giocatore alla partita");
-            pthread_mutex_unlock(&server_state.mutex);
-            protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+            unlock_game(game);
+            send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
         }
     } else {
         // RIFIUTA
-        LOG_INFO("Join rifiutato da creatore per partita '%s'", game->state.game_id);
+        LOG_INFO("Join rifiutato da creatore per partita '%s'", game_id);
         
         // Resetta stato joiner
-        int joiner_idx = find_client_by_fd(joiner_fd);
-        if (joiner_idx != -1) {
-            server_state.clients[joiner_idx].status = CLIENT_REGISTERED;
-        }
-        
-        game->pending_join_fd = -1;
-        
-        pthread_mutex_unlock(&server_state.mutex);
+        set_client_game(joiner, CLIENT_REGISTERED, -1, -1);
+        game->pending_join_conn = CONN_NONE;
+        players_release(game->pending_join_id);
+        game->pending_join_id = PLAYER_NONE;
         
         // Invia risposte
         response.status = STATUS_OK;
         response.error_code = ERR_NONE;
-        protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+        send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
         
         // Notifica al joiner: rifiutato
-        pthread_mutex_lock(&server_state.mutex);
-        notify_join_response(joiner_fd, game->state.game_id, 0);
-        pthread_mutex_unlock(&server_state.mutex);
+        notify_join_response(joiner, game_id, 0);
+        unlock_game(game);
     }
 }
 
@@ -972,44 +1714,23 @@ void handle_make_move(int client_fd, const void *payload, uint16_t length) {
     response.status = STATUS_ERROR;
     response.error_code = ERR_INTERNAL;
     
-    pthread_mutex_lock(&server_state.mutex);
-    
-    // Trova client e partita
-    int client_idx = find_client_by_fd(client_fd);
-    if (client_idx == -1) {
-        LOG_WARN("Client FD=%d non trovato", client_fd);
-        response.error_code = ERR_NOT_IN_GAME;
-        pthread_mutex_unlock(&server_state.mutex);
-        protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
-        return;
-    }
-    
-    client_info_t *client = &server_state.clients[client_idx];
-    
-    // Deve essere in partita
-    if (client->status != CLIENT_IN_GAME) {
+    // Trova la partita senza il registro dei client: serve solo il lock di questa partita
+    int player_index;
+    game_session_t *game = lock_playing_game(client_fd, &player_index);
+    if (!game) {
         LOG_WARN("Client FD=%d non in partita", client_fd);
         response.error_code = ERR_NOT_IN_GAME;
-        pthread_mutex_unlock(&server_state.mutex);
-        protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
-        return;
-    }
-    
-    game_session_t *game = &server_state.games[client->game_index];
-
-    // Controlla se la partita è attiva
-    if (!game->active) {
-        LOG_ERROR("Partita non attiva per client FD=%d", client_fd);
-        pthread_mutex_unlock(&server_state.mutex);
-        protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+        send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
         return;
     }
+    player_id_t player_id = game->state.players[player_index];
+    const char *player_name = players_name(player_id);
     
     // Valida payload
     if (length < sizeof(payload_make_move_t)) {
         LOG_ERROR("Payload MSG_MAKE_MOVE invalido");
-        pthread_mutex_unlock(&server_state.mutex);
-        protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+        unlock_game(game);
+        send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
         return;
     }
     
@@ -1019,91 +1740,97 @@ void handle_make_move(int client_fd, const void *payload, uint16_t length) {
     if (!protocol_validate_move(move->pos)) {
         LOG_WARN("Posizione invalida: %d", move->pos);
         response.error_code = ERR_INVALID_MOVE;
-        pthread_mutex_unlock(&server_state.mutex);
-        protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+        unlock_game(game);
+        send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
         return;
     }
     
     // Controlla se è il turno del giocatore
-    if (!game_is_player_turn(&game->state, client->name)) {
-        LOG_WARN("Non è il turno di '%s'", client->name);
+    if (!game_is_player_turn(&game->state, player_id)) {
+        LOG_WARN("Non è il turno di '%s'", player_name);
         response.error_code = ERR_NOT_YOUR_TURN;
-        pthread_mutex_unlock(&server_state.mutex);
-        protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+        unlock_game(game);
+        send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
         return;
     }
     
     // Effettua la mossa
-    if (!game_make_move(&game->state, client->player_index, move->pos)) {
-        LOG_WARN("Mossa non valida per '%s' pos=%d", client->name, move->pos);
+    if (!game_make_move(&game->state, player_index, move->pos)) {
+        LOG_WARN("Mossa non valida per '%s' pos=%d", player_name, move->pos);
         response.error_code = ERR_CELL_OCCUPIED;
-        pthread_mutex_unlock(&server_state.mutex);
-        protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+        unlock_game(game);
+        send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
         return;
     }
     
+    // Il contatore resta fermo tra una mossa e l'altra: nessuna allocazione a regime
+    char game_id[MAX_GAME_ID_LEN];
+    game_session_id(game, game_id);
     LOG_INFO("Mossa effettuata: giocatore='%s', pos=%d, partita='%s'",
-             client->name, move->pos, game->state.game_id);
+             player_name, move->pos, game_id);
+    LOG_DEBUG("Allocazioni heap del thread: %lu", get_request_allocs());
     
     // Mossa OK
     response.status = STATUS_OK;
     response.error_code = ERR_NONE;
     
     // Trova l'avversario
-    int opponent_idx = 1 - client->player_index;
-    int opponent_fd = game->player_fds[opponent_idx];
+    int opponent_idx = 1 - player_index;
+    conn_t opponent = game->player_conns[opponent_idx];
     
     // Prepara board per notifiche
     char board_str[BOARD_SIZE];
     game_get_board_string(&game->state, board_str);
     
-    pthread_mutex_unlock(&server_state.mutex);
-    
-    // Invia risposta al giocatore
-    protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
-    
     // Controlla se la partita è finita
     if (game_is_finished(&game->state)) {
-        LOG_INFO("Partita '%s' terminata", game->state.game_id);
+        LOG_INFO("Partita '%s' terminata", game_id);
         
-        // Notifica fine partita a entrambi
+        // Prepara la notifica di fine partita per entrambi
+        notify_game_end_t notify[2];
         for (int i = 0; i < 2; i++) {
-            notify_game_end_t notify;
-            notify.notify_type = NOTIFY_GAME_END;
-
-            pthread_mutex_lock(&server_state.mutex);
-            memcpy(notify.board, board_str, BOARD_SIZE);
+            notify[i].notify_type = NOTIFY_GAME_END;
+            memcpy(notify[i].board, board_str, BOARD_SIZE);
             
             // Determina risultato per questo giocatore
-            if (game->state.winner == 2) {
-                notify.result = RESULT_DRAW;
-            } else if (game->state.winner == i) {
-                notify.result = RESULT_WIN;
+            if (GAME_WINNER(&game->state) == 2) {
+                notify[i].result = RESULT_DRAW;
+            } else if (GAME_WINNER(&game->state) == i) {
+                notify[i].result = RESULT_WIN;
             } else {
-                notify.result = RESULT_LOSE;
+                notify[i].result = RESULT_LOSE;
             }
-            
-            pthread_mutex_unlock(&server_state.mutex);
-            
-            protocol_send(game->player_fds[i], MSG_NOTIFY, &notify, sizeof(notify), 0);
-            LOG_DEBUG("GAME_END inviato a FD=%d, result=%d", game->player_fds[i], notify.result);
         }
         
         // Cleanup partita
         cleanup_game(game);
+        unlock_game(game);
+        
+        // Al giocatore: risposta e fine partita con un solo invio
+        protocol_frame_t frames[2] = {
+            { MSG_RESPONSE, &response, sizeof(response), 0 },
+            { MSG_NOTIFY, &notify[player_index], sizeof(notify_game_end_t), 0 }
+        };
+        send_batch_to_client(client_fd, frames, 2);
+        LOG_DEBUG("GAME_END inviato a FD=%d, result=%d", client_fd, notify[player_index].result);
+        
+        send_to_conn(opponent, MSG_NOTIFY, &notify[opponent_idx], sizeof(notify_game_end_t));
+        LOG_DEBUG("GAME_END inviato a FD=%d, result=%d", CONN_FD(opponent), notify[opponent_idx].result);
     } else {
         // Partita continua: notifica mossa all'avversario
         notify_move_made_t notify_move;
         notify_move.notify_type = NOTIFY_MOVE_MADE;
-
-        pthread_mutex_lock(&server_state.mutex);
         notify_move.pos = move->pos;
-        notify_move.symbol = game_get_player_symbol(&game->state, client->player_index);
+        notify_move.symbol = game_get_player_symbol(player_index);
         memcpy(notify_move.board, board_str, BOARD_SIZE);
         
-        pthread_mutex_unlock(&server_state.mutex);
-        protocol_send(opponent_fd, MSG_NOTIFY, &notify_move, sizeof(notify_move), 0);
-        LOG_DEBUG("MOVE_MADE inviato a FD=%d", opponent_fd);
+        unlock_game(game);
+        
+        // Invia risposta al giocatore
+        send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
+        
+        send_to_conn(opponent, MSG_NOTIFY, &notify_move, sizeof(notify_move));
+        LOG_DEBUG("MOVE_MADE inviato a FD=%d", CONN_FD(opponent));
     }
 
 }
@@ -1115,74 +1842,73 @@ void handle_leave_game(int client_fd) {
     response.status = STATUS_ERROR;
     response.error_code = ERR_INTERNAL;
     
-    pthread_mutex_lock(&server_state.mutex);
-    
-    // Trova client
-    int client_idx = find_client_by_fd(client_fd);
-    if (client_idx == -1) {
+    // Trova client e blocca la partita a cui è legato
+    client_snapshot_t client;
+    game_session_t *game = lock_client_game(client_fd, &client);
+    if (client.fd == -1) {
         LOG_WARN("Client FD=%d non trovato", client_fd);
         response.error_code = ERR_NOT_IN_GAME;
-        pthread_mutex_unlock(&server_state.mutex);
-        protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+        send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
         return;
     }
 
-    client_info_t *client = &server_state.clients[client_idx];
-
-    if (client->status == CLIENT_REQUESTING_JOIN) {
-        send_join_cancellation_notify_to_original_creator(client_fd);        
-        cleanup_pending_join(client_fd);
-        client->status = CLIENT_REGISTERED;
-        pthread_mutex_unlock(&server_state.mutex);
+    if (client.status == CLIENT_REQUESTING_JOIN) {
+        if (game) {
+            send_join_cancellation_notify_to_original_creator(game, client.name);
+            cleanup_pending_join(game);
+            unlock_game(game);
+        } else {
+            set_client_game(client.conn, CLIENT_REGISTERED, -1, -1);
+        }
 
         response.status = STATUS_OK;
         response.error_code = ERR_NONE;
-        protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+        send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
         return;
     }
 
     // Deve essere in partita o in lobby, se non stava richiedendo join
-    if (client->status != CLIENT_IN_GAME && client->status != CLIENT_IN_LOBBY) {
+    if (!game || (client.status != CLIENT_IN_GAME && client.status != CLIENT_IN_LOBBY)) {
         LOG_WARN("Client FD=%d non in partita", client_fd);
         response.error_code = ERR_NOT_IN_GAME;
-        pthread_mutex_unlock(&server_state.mutex);
-        protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+        if (game) unlock_game(game);
+        send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
         return;
     }
 
-    game_session_t *game = &server_state.games[client->game_index];
-
     // Controlla se la partita è attiva
     if (!game->active) {
         LOG_ERROR("Partita non attiva");
-        pthread_mutex_unlock(&server_state.mutex);
-        protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+        unlock_game(game);
+        send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
         return;
     }
     
+    char game_id[MAX_GAME_ID_LEN];
+    game_session_id(game, game_id);
     LOG_INFO("Client '%s' (FD=%d) abbandona partita '%s'", 
-             client->name, client_fd, game->state.game_id);
+             client.name, client_fd, game_id);
     
     // Trova avversario
-    int opponent_idx = 1 - client->player_index;
-    int opponent_fd = game->player_fds[opponent_idx];
+    int opponent_idx = 1 - client.player_index;
+    conn_t opponent = game->player_conns[opponent_idx];
     
     // Pulisci la partita (cleanup_game resetta anche l'avversario a REGISTERED)
     cleanup_game(game);
     
-    pthread_mutex_unlock(&server_state.mutex);
+    unlock_game(game);
     
     // Invia risposta
     response.status = STATUS_OK;
     response.error_code = ERR_NONE;
-    protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);
+    send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));
     
     // Notifica avversario
-    if (opponent_fd > 0) {
+    if (!CONN_IS_NONE(opponent)) {
         notify_opponent_left_t notify;
         notify.notify_type = NOTIFY_OPPONENT_LEFT;
-        protocol_send(opponent_fd, MSG_NOTIFY, &notify, sizeof(notify), 0);
-        LOG_INFO("OPPONENT_LEFT inviato a FD=%d", opponent_fd);
+        send_to_conn(opponent, MSG_NOTIFY, &notify, sizeof(notify));
+        LOG_INFO("OPPONENT_LEFT inviato a FD=%d", CONN_FD(opponent));
     }
 }
 
@@ -1195,7 +1921,7 @@ void handle_quit(int client_fd) {
 
     handle_disconnect(client_fd);
 
-    protocol_send(client_fd, MSG_RESPONSE, &response, sizeof(response), 0);    
+    send_to_client(client_fd, MSG_RESPONSE, &response, sizeof(response));    
 }
 
 // ============================================================================
@@ -1207,79 +1933,83 @@ void send_list_games_error(int client_fd, error_code_t error) {
     err_response.status = STATUS_ERROR;
     err_response.error_code = error;
     err_response.game_count = 0;
-    protocol_send(client_fd, MSG_RESPONSE, &err_response, sizeof(err_response), 0);
+    send_to_client(client_fd, MSG_RESPONSE, &err_response, sizeof(err_response));
 }
 
-void send_join_cancellation_notify_to_original_creator(int client_fd) {
-    for (int i = 0; i < server_state.max_games; i++) {
-        game_session_t *game = &server_state.games[i];
-        if (game->active && game->pending_join_fd == client_fd) {
-            int creator_fd = game->player_fds[0];
-            client_info_t *joiner = &server_state.clients[find_client_by_fd(client_fd)];
-
-            notify_join_cancellation_t notify;
-            notify.notify_type = NOTIFY_JOIN_CANCELLATION;
-            strncpy(notify.opponent, joiner->name, MAX_PLAYER_NAME - 1);
-            notify.opponent[MAX_PLAYER_NAME - 1] = '\0';
-            
-            protocol_send(creator_fd, MSG_NOTIFY, &notify, sizeof(notify), 0);
-            LOG_INFO("NOTIFY_JOIN_CANCELLATION inviato a creatore FD=%d", creator_fd);
-            
-            break;
-        }
-    }
+void send_join_cancellation_notify_to_original_creator(game_session_t *game, const char *joiner_name) {
+    if (!game->active || CONN_IS_NONE(game->pending_join_conn)) return;
+    
+    conn_t creator = game->player_conns[0];
+
+    notify_join_cancellation_t notify;
+    notify.notify_type = NOTIFY_JOIN_CANCELLATION;
+    strncpy(notify.opponent, joiner_name, MAX_PLAYER_NAME - 1);
+    notify.opponent[MAX_PLAYER_NAME - 1] = '\0';
+    
+    send_to_conn(creator, MSG_NOTIFY, &notify, sizeof(notify));
+    LOG_INFO("NOTIFY_JOIN_CANCELLATION inviato a creatore FD=%d", CONN_FD(creator));
 }
 
-void cleanup_pending_join(int client_fd) {
-    for (int i = 0; i < server_state.max_games; i++) {
-        game_session_t *game = &server_state.games[i];
-        if (game->active && game->pending_join_fd == client_fd) {
-            game->pending_join_fd = -1;
-            game->pending_join_name[0] = '\0';
-            break;
-        }
-    }
+void cleanup_pending_join(game_session_t *game) {
+    conn_t joiner = game->pending_join_conn;
+    if (CONN_IS_NONE(joiner)) return;
+    
+    game->pending_join_conn = CONN_NONE;
+    players_release(game->pending_join_id);
+    game->pending_join_id = PLAYER_NONE;
+    
+    pthread_mutex_lock(&server_state.clients_lock);
+    release_client_from_game(joiner, (int)(game - server_state.games));
+    pthread_mutex_unlock(&server_state.clients_lock);
 }
 
 void handle_disconnect(int client_fd) {
-    pthread_mutex_lock(&server_state.mutex);
-    
-    // Trova il client
-    int client_idx = find_client_by_fd(client_fd);
-    if (client_idx != -1) {
-        client_info_t *client = &server_state.clients[client_idx];
-        
-        if (client->status == CLIENT_REQUESTING_JOIN)
+    // Trova il client e blocca la partita a cui è legato
+    client_snapshot_t client;
+    game_session_t *game = lock_client_game(client_fd, &client);
+    if (game) {
+        if (client.status == CLIENT_REQUESTING_JOIN)
         {
-            send_join_cancellation_notify_to_original_creator(client_fd);        
-            cleanup_pending_join(client_fd);
+            send_join_cancellation_notify_to_original_creator(game, client.name);
+            cleanup_pending_join(game);
             LOG_INFO("Client '%s' (FD=%d) disconnesso durante richiesta join, notifica inviata",
-                     client->name, client_fd);
+                     client.name, client_fd);
         }
-        else if (client->status == CLIENT_IN_GAME) {
-            game_session_t *game = &server_state.games[client->game_index];
-            
+        else if (client.status == CLIENT_IN_GAME) {
             if (game->active) {
                 // Trova l'avversario
-                int opponent_idx = 1 - client->player_index;
-                int opponent_fd = game->player_fds[opponent_idx];
+                int opponent_idx = 1 - client.player_index;
+                conn_t opponent = game->player_conns[opponent_idx];
                 
                 // Notifica l'avversario che il giocatore ha abbandonato
-                if (opponent_fd > 0) {
+                if (!CONN_IS_NONE(opponent)) {
                     notify_opponent_left_t notify;
                     notify.notify_type = NOTIFY_OPPONENT_LEFT;
-                    protocol_send(opponent_fd, MSG_NOTIFY, &notify, sizeof(notify), 0);
+                    send_to_conn(opponent, MSG_NOTIFY, &notify, sizeof(notify));
                     
                     LOG_INFO("Notifica OPPONENT_LEFT inviata a FD=%d (client '%s' disconnesso)",
-                             opponent_fd, client->name);
+                             CONN_FD(opponent), client.name);
                 }
 
                 cleanup_game(game);
             }
         }
+        else if (client.status == CLIENT_IN_LOBBY) {
+            // Come handle_leave_game(): la partita in attesa non deve restare in lista
+            if (game->active) {
+                char game_id[MAX_GAME_ID_LEN];
+                game_session_id(game, game_id);
+                LOG_INFO("Client '%s' (FD=%d) disconnesso in lobby, partita '%s' rimossa",
+                         client.name, client_fd, game_id);
+                cleanup_game(game);
+            }
+        }
+        
+        unlock_game(game);
     }
-
-    pthread_mutex_unlock(&server_state.mutex);
+    
+    // Notifiche all'avversario o al creatore scritte fuori dai lock
+    outbound_flush_pending();
 }
 
 // ============================================================================
@@ -1289,11 +2019,11 @@ void handle_disconnect(int client_fd) {
 void broadcast_to_registered_clients(uint8_t msg_type, const void *payload, size_t payload_size) {
     for (int i = 0; i < server_state.num_clients; i++) {
         if (server_state.clients[i].status == CLIENT_REGISTERED) {
-            ssize_t sent = protocol_send(server_state.clients[i].fd, msg_type, 
-                                        payload, payload_size, 0);
+            ssize_t sent = send_to_client(server_state.clients[i].fd, msg_type, 
+                                         payload, payload_size);
             if (sent > 0) {
                 LOG_DEBUG("Broadcast inviato a client FD=%d (%s)", 
-                         server_state.clients[i].fd, server_state.clients[i].name);
+                         server_state.clients[i].fd, server_state.clients_cold[i].name);
             } else {
                 LOG_WARN("Errore invio broadcast a FD=%d", server_state.clients[i].fd);
             }
@@ -1301,47 +2031,47 @@ void broadcast_to_registered_clients(uint8_t msg_type, const void *payload, size
     }
 }
 
-void notify_join_request(int creator_fd, const char *joiner_name) {
+void notify_join_request(conn_t creator, const char *joiner_name) {
     notify_join_request_t notify;
     notify.notify_type = NOTIFY_JOIN_REQUEST;
     strncpy(notify.opponent, joiner_name, MAX_PLAYER_NAME - 1);
     notify.opponent[MAX_PLAYER_NAME - 1] = '\0';
     
-    protocol_send(creator_fd, MSG_NOTIFY, &notify, sizeof(notify), 0);
+    send_to_conn(creator, MSG_NOTIFY, &notify, sizeof(notify));
     LOG_INFO("Notifica JOIN_REQUEST inviata a FD=%d: joiner='%s'", 
-             creator_fd, joiner_name);
+             CONN_FD(creator), joiner_name);
 }
 
-void notify_join_response(int joiner_fd, const char *game_id, int accepted) {
+void notify_join_response(conn_t joiner, const char *game_id, int accepted) {
     notify_join_response_t notify;
     notify.notify_type = NOTIFY_JOIN_RESPONSE;
     notify.accepted = accepted ? 1 : 0;
     strncpy(notify.game_id, game_id, MAX_GAME_ID_LEN - 1);
     notify.game_id[MAX_GAME_ID_LEN - 1] = '\0';
     
-    protocol_send(joiner_fd, MSG_NOTIFY, &notify, sizeof(notify), 0);
+    send_to_conn(joiner, MSG_NOTIFY, &notify, sizeof(notify));
     LOG_INFO("Notifica JOIN_RESPONSE inviata a FD=%d: game_id='%s', accepted=%d",
-             joiner_fd, game_id, accepted);
+             CONN_FD(joiner), game_id, accepted);
 }
 
 void notify_game_start(game_session_t *game) {
     if (!game || !game->active) return;
     
     for (int i = 0; i < 2; i++) {
-        if (game->player_fds[i] <= 0) continue;
+        if (CONN_IS_NONE(game->player_conns[i])) continue;
         
         notify_game_start_t notify;
         notify.notify_type = NOTIFY_GAME_START;
-        notify.your_symbol = game_get_player_symbol(&game->state, i);
+        notify.your_symbol = game_get_player_symbol(i);
         notify.first_player = PLAYER_X;  // X inizia sempre
         
         // Imposta il nome dell'avversario
         int opponent_idx = 1 - i;
-        strncpy(notify.opponent, game->state.players[opponent_idx], MAX_PLAYER_NAME - 1);
+        strncpy(notify.opponent, players_name(game->state.players[opponent_idx]), MAX_PLAYER_NAME - 1);
         notify.opponent[MAX_PLAYER_NAME - 1] = '\0';
         
-        protocol_send(game->player_fds[i], MSG_NOTIFY, &notify, sizeof(notify), 0);
+        send_to_conn(game->player_conns[i], MSG_NOTIFY, &notify, sizeof(notify));
         LOG_INFO("Notifica GAME_START inviata a FD=%d: symbol='%c', opponent='%s'",
-                 game->player_fds[i], notify.your_symbol, notify.opponent);
+                 CONN_FD(game->player_conns[i]), notify.your_symbol, notify.opponent);
     }
 }
\ No newline at end of file
@@ -0,0 +1,382 @@
+#include "tables.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// ============================================================================
+// STATO DELLE TABELLE
+// ============================================================================
+
+// Segmenti pubblicati della tabella dei client (protetti da clients_lock)
+static int client_segments = 0;
+static int client_max_segments = 0;
+
+/**
+ * Segmento della tabella delle partite (protetto da lobby_lock)
+ */
+typedef struct {
+    int free_head;                      // Primo slot libero del segmento (-1 se pieno)
+    int used;                           // Slot prelevati e non ancora liberati
+    uint64_t retired_at;                // Sequenza di ritiro (se oltre i segmenti pubblicati)
+} game_segment_t;
+
+static game_segment_t *game_segments = NULL;
+// Bit s = segmento s pubblicato e con almeno uno slot libero
+static uint64_t *games_with_free = NULL;
+static int game_max_segments = 0;
+static int game_live_segments = 0;      // Segmenti pubblicati
+static int game_mapped_segments = 0;    // Segmenti con le pagine ancora in uso (>= pubblicati)
+static int game_capacity = 0;           // Slot pubblicati (scritto sotto lobby_lock, letto senza lock)
+static int reclaim_pending = 0;         // Segmenti ritirati con pagine da restituire (atomico)
+
+/**
+ * Thread che usa le partite, per sapere quando un segmento ritirato è libero
+ *
+ * 'entered' vale la sequenza di ritiro letta entrando in lock_game_slot()
+ * e 0 fuori: un segmento ritirato con sequenza R può tornare al sistema
+ * quando nessun thread è dentro con un valore minore di R. I record non
+ * vengono mai liberati; quelli dei thread terminati vengono riusati.
+ */
+typedef struct game_reader {
+    uint64_t entered __attribute__((aligned(CACHE_LINE_SIZE)));
+    struct game_reader *next;           // Tutti i record (immutabile dopo l'inserimento)
+    struct game_reader *next_free;      // Record riusabili (protetto da readers_lock)
+} game_reader_t;
+
+static game_reader_t *readers = NULL;
+static game_reader_t *free_readers = NULL;
+static pthread_mutex_t readers_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t reader_key;
+static pthread_once_t reader_once = PTHREAD_ONCE_INIT;
+static __thread game_reader_t *current_reader = NULL;
+static uint64_t retire_seq = 1;
+
+// ============================================================================
+// FUNZIONI DI SUPPORTO
+// ============================================================================
+
+// Stati del lock di una partita (game_session_t.lock)
+#define GAME_UNLOCKED 0u
+#define GAME_LOCKED 1u                  // Acquisito, nessuno in attesa
+#define GAME_CONTENDED 2u               // Acquisito, forse qualcuno dorme sul futex
+
+/**
+ * Acquisisce il lock da 4 byte di una partita
+ *
+ * Mutex su futex: senza contesa costa un compare-and-swap, come
+ * pthread_mutex_t, ma occupa 4 byte invece di 40 e lascia il resto della
+ * riga di cache alla partita. Chi deve attendere segna il lock come
+ * conteso e dorme nel kernel.
+ */
+static void game_mutex_lock(uint32_t *lock) {
+    uint32_t state = GAME_UNLOCKED;
+    if (__atomic_compare_exchange_n(lock, &state, GAME_LOCKED, false,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        return;
+    }
+    if (state != GAME_CONTENDED) {
+        state = __atomic_exchange_n(lock, GAME_CONTENDED, __ATOMIC_ACQUIRE);
+    }
+    while (state != GAME_UNLOCKED) {
+        syscall(SYS_futex, lock, FUTEX_WAIT_PRIVATE, GAME_CONTENDED, NULL, NULL, 0);
+        state = __atomic_exchange_n(lock, GAME_CONTENDED, __ATOMIC_ACQUIRE);
+    }
+}
+
+// Rilascia il lock di una partita, svegliando un thread in attesa se serve
+static void game_mutex_unlock(uint32_t *lock) {
+    if (__atomic_exchange_n(lock, GAME_UNLOCKED, __ATOMIC_RELEASE) == GAME_CONTENDED) {
+        syscall(SYS_futex, lock, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+    }
+}
+
+// Regione di soli indirizzi: le pagine vengono impegnate al primo accesso
+static void *reserve_region(size_t bytes) {
+    void *region = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    return region == MAP_FAILED ? NULL : region;
+}
+
+// Restituisce al sistema le pagine intere dell'intervallo (rilette come zeri)
+static void release_pages(void *start, size_t bytes) {
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t begin = ((uintptr_t)start + page - 1) & ~(page - 1);
+    uintptr_t end = ((uintptr_t)start + bytes) & ~(page - 1);
+    if (end > begin && madvise((void*)begin, end - begin, MADV_DONTNEED) != 0) {
+        LOG_WARN("madvise(MADV_DONTNEED) fallita: le pagine restano impegnate");
+    }
+}
+
+static void reader_release(void *arg) {
+    game_reader_t *reader = arg;
+    pthread_mutex_lock(&readers_lock);
+    reader->next_free = free_readers;
+    free_readers = reader;
+    pthread_mutex_unlock(&readers_lock);
+}
+
+static void reader_key_init(void) {
+    pthread_key_create(&reader_key, reader_release);
+}
+
+// Record del thread corrente, creato (o riusato) al primo lock di una partita
+static game_reader_t *reader_register(void) {
+    pthread_once(&reader_once, reader_key_init);
+
+    pthread_mutex_lock(&readers_lock);
+    game_reader_t *reader = free_readers;
+    if (reader) {
+        free_readers = reader->next_free;
+    } else {
+        reader = aligned_alloc(CACHE_LINE_SIZE, sizeof(game_reader_t));
+        if (reader) {
+            memset(reader, 0, sizeof(*reader));
+            reader->next = readers;
+            __atomic_store_n(&readers, reader, __ATOMIC_RELEASE);
+        }
+    }
+    pthread_mutex_unlock(&readers_lock);
+
+    if (reader) {
+        pthread_setspecific(reader_key, reader);
+    }
+    return reader;
+}
+
+// Nessun thread è entrato in lock_game_slot() prima della sequenza 'seq' ed è ancora dentro
+static bool readers_left(uint64_t seq) {
+    for (game_reader_t *r = __atomic_load_n(&readers, __ATOMIC_ACQUIRE); r; r = r->next) {
+        uint64_t entered = __atomic_load_n(&r->entered, __ATOMIC_SEQ_CST);
+        if (entered != 0 && entered < seq) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Pubblica il segmento successivo della tabella delle partite
+ *
+ * Un segmento ritirato ma non ancora restituito ha la memoria intatta (e
+ * forse un lettore con un indirizzo vecchio dentro un suo lock): si rifà
+ * solo la lista libera. Le pagine nuove o restituite vengono inizializzate.
+ *
+ * @note Richiede che server_state.lobby_lock sia già acquisito
+ */
+static void game_publish_segment(void) {
+    int s = game_live_segments;
+    int first = s * GAME_SEGMENT_SLOTS;
+    int last = first + GAME_SEGMENT_SLOTS;
+    if (last > server_state.max_games) last = server_state.max_games;
+    bool fresh = (s >= game_mapped_segments);
+
+    for (int i = first; i < last; i++) {
+        game_session_t *game = &server_state.games[i];
+        if (fresh) {
+            game->lock = GAME_UNLOCKED;
+            game->active = 0;
+            game->pending_join_conn = CONN_NONE;
+            game->pending_join_id = PLAYER_NONE;
+            game->generation = 0;
+            game->waiting = 0;
+            game->wait_prev = -1;
+            game->wait_next = -1;
+        }
+        game->next_free = (i + 1 < last) ? i + 1 : -1;
+    }
+
+    game_segments[s].free_head = first;
+    game_segments[s].used = 0;
+    game_segments[s].retired_at = 0;
+    games_with_free[s / 64] |= 1ULL << (s % 64);
+    if (fresh) game_mapped_segments = s + 1;
+    game_live_segments = s + 1;
+
+    // Slot inizializzati prima di diventare visibili a lock_game_slot()
+    __atomic_store_n(&game_capacity, last, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * Ritira l'ultimo segmento pubblicato (vuoto)
+ *
+ * @note Richiede che server_state.lobby_lock sia già acquisito
+ */
+static void game_retire_segment(void) {
+    int s = game_live_segments - 1;
+
+    games_with_free[s / 64] &= ~(1ULL << (s % 64));
+    game_segments[s].free_head = -1;
+    game_live_segments = s;
+
+    // Da qui nessun nuovo lettore entra nel segmento; quelli già dentro hanno sequenza minore
+    __atomic_store_n(&game_capacity, s * GAME_SEGMENT_SLOTS, __ATOMIC_SEQ_CST);
+    game_segments[s].retired_at = __atomic_add_fetch(&retire_seq, 1, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&reclaim_pending, 1, __ATOMIC_RELAXED);
+
+    LOG_INFO("Tabella partite ridotta a %d segmenti (%d slot)",
+             game_live_segments, game_live_segments * GAME_SEGMENT_SLOTS);
+}
+
+/**
+ * Restituisce le pagine dei segmenti ritirati che nessun lettore può più toccare
+ *
+ * @note Richiede che server_state.lobby_lock sia già acquisito
+ */
+static void games_reclaim(void) {
+    while (game_mapped_segments > game_live_segments) {
+        int s = game_mapped_segments - 1;
+        if (!readers_left(game_segments[s].retired_at)) {
+            return;
+        }
+        release_pages(&server_state.games[s * GAME_SEGMENT_SLOTS],
+                      GAME_SEGMENT_SLOTS * sizeof(game_session_t));
+        game_mapped_segments = s;
+        LOG_DEBUG("Tabella partite: pagine del segmento %d restituite", s);
+    }
+    __atomic_store_n(&reclaim_pending, 0, __ATOMIC_RELAXED);
+}
+
+// ============================================================================
+// API PUBBLICA
+// ============================================================================
+
+int tables_init(void) {
+    int max_clients = server_state.max_clients > 0 ? server_state.max_clients : 1;
+    int max_games = server_state.max_games > 0 ? server_state.max_games : 1;
+    client_max_segments = (max_clients + CLIENT_SEGMENT_SLOTS - 1) / CLIENT_SEGMENT_SLOTS;
+    game_max_segments = (max_games + GAME_SEGMENT_SLOTS - 1) / GAME_SEGMENT_SLOTS;
+
+    size_t client_slots = (size_t)client_max_segments * CLIENT_SEGMENT_SLOTS;
+    size_t game_slots = (size_t)game_max_segments * GAME_SEGMENT_SLOTS;
+    server_state.clients = reserve_region(client_slots * sizeof(client_info_t));
+    server_state.clients_cold = reserve_region(client_slots * sizeof(client_cold_t));
+    server_state.games = reserve_region(game_slots * sizeof(game_session_t));
+    game_segments = calloc(game_max_segments, sizeof(game_segment_t));
+    games_with_free = calloc((game_max_segments + 63) / 64, sizeof(uint64_t));
+    if (!server_state.clients || !server_state.clients_cold || !server_state.games ||
+        !game_segments || !games_with_free) {
+        LOG_ERROR("Impossibile riservare le tabelle per %d client e %d partite",
+                  server_state.max_clients, server_state.max_games);
+        return -1;
+    }
+
+    client_segments = 1;
+    pthread_mutex_lock(&server_state.lobby_lock);
+    game_publish_segment();
+    pthread_mutex_unlock(&server_state.lobby_lock);
+
+    LOG_INFO("Tabelle riservate: segmenti da %d client (max %d) e da %d partite (max %d)",
+             CLIENT_SEGMENT_SLOTS, client_max_segments, GAME_SEGMENT_SLOTS, game_max_segments);
+    return 0;
+}
+
+void clients_table_fit(int count) {
+    while (count > client_segments * CLIENT_SEGMENT_SLOTS && client_segments < client_max_segments) {
+        client_segments++;
+        LOG_INFO("Tabella client estesa a %d segmenti (%d slot)",
+                 client_segments, client_segments * CLIENT_SEGMENT_SLOTS);
+    }
+
+    // Il segmento subito dopo l'ultimo client resta di riserva
+    while (client_segments > 1 && count <= (client_segments - 2) * CLIENT_SEGMENT_SLOTS) {
+        client_segments--;
+        size_t first = (size_t)client_segments * CLIENT_SEGMENT_SLOTS;
+        release_pages(&server_state.clients[first], CLIENT_SEGMENT_SLOTS * sizeof(client_info_t));
+        release_pages(&server_state.clients_cold[first], CLIENT_SEGMENT_SLOTS * sizeof(client_cold_t));
+        LOG_INFO("Tabella client ridotta a %d segmenti (%d slot)",
+                 client_segments, client_segments * CLIENT_SEGMENT_SLOTS);
+    }
+}
+
+int games_table_alloc(void) {
+    games_reclaim();
+
+    // Segmento più basso con uno slot libero
+    int s = -1;
+    int words = (game_live_segments + 63) / 64;
+    for (int w = 0; w < words; w++) {
+        if (games_with_free[w]) {
+            s = w * 64 + __builtin_ctzll(games_with_free[w]);
+            break;
+        }
+    }
+    if (s == -1) {
+        if (game_live_segments >= game_max_segments) {
+            return -1;
+        }
+        s = game_live_segments;
+        game_publish_segment();
+        LOG_INFO("Tabella partite estesa a %d segmenti (%d slot)",
+                 game_live_segments, game_capacity);
+    }
+
+    game_segment_t *segment = &game_segments[s];
+    int slot = segment->free_head;
+    segment->free_head = server_state.games[slot].next_free;
+    server_state.games[slot].next_free = -1;
+    segment->used++;
+    if (segment->free_head == -1) {
+        games_with_free[s / 64] &= ~(1ULL << (s % 64));
+    }
+    return slot;
+}
+
+void games_table_free(int slot) {
+    int s = slot / GAME_SEGMENT_SLOTS;
+    game_segment_t *segment = &game_segments[s];
+
+    server_state.games[slot].next_free = segment->free_head;
+    segment->free_head = slot;
+    segment->used--;
+    games_with_free[s / 64] |= 1ULL << (s % 64);
+
+    // In coda resta sempre un segmento vuoto di riserva
+    while (game_live_segments >= 2 &&
+           game_segments[game_live_segments - 1].used == 0 &&
+           game_segments[game_live_segments - 2].used == 0) {
+        game_retire_segment();
+    }
+}
+
+int games_table_capacity(void) {
+    return __atomic_load_n(&game_capacity, __ATOMIC_ACQUIRE);
+}
+
+game_session_t *lock_game_slot(int slot) {
+    game_reader_t *reader = current_reader;
+    if (!reader) {
+        reader = current_reader = reader_register();
+        if (!reader) {
+            LOG_ERROR("Errore allocazione del record di lettura delle partite");
+            return NULL;
+        }
+    }
+
+    // Prima ci si dichiara dentro, poi si controlla lo slot: un ritiro successivo ci aspetta
+    __atomic_store_n(&reader->entered, __atomic_load_n(&retire_seq, __ATOMIC_SEQ_CST),
+                     __ATOMIC_SEQ_CST);
+    if (slot < 0 || slot >= __atomic_load_n(&game_capacity, __ATOMIC_SEQ_CST)) {
+        __atomic_store_n(&reader->entered, 0, __ATOMIC_RELEASE);
+        return NULL;
+    }
+
+    game_session_t *game = &server_state.games[slot];
+    game_mutex_lock(&game->lock);
+    return game;
+}
+
+void unlock_game(game_session_t *game) {
+    game_mutex_unlock(&game->lock);
+    __atomic_store_n(&current_reader->entered, 0, __ATOMIC_RELEASE);
+
+    // Un ritiro in attesa di questo thread si completa qui, senza mai attendere la lobby
+    if (__atomic_load_n(&reclaim_pending, __ATOMIC_RELAXED) &&
+        pthread_mutex_trylock(&server_state.lobby_lock) == 0) {
+        games_reclaim();
+        pthread_mutex_unlock(&server_state.lobby_lock);
+    }
+}
@@ -0,0 +1,251 @@
+#include "timers.h"
+#include "utils.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+// Limite alla tabella indicizzata per fd se RLIMIT_NOFILE è illimitato
+#define TIMERS_MAX_FDS (1 << 20)
+// Durata di un tick e numero di slot (potenza di 2): un giro copre ~64 s
+#define TIMER_TICK_MS 250
+#define TIMER_WHEEL_SLOTS 256
+
+// ============================================================================
+// STATO DELLA RUOTA
+// ============================================================================
+
+/**
+ * Timer di una connessione, collegato nella lista del proprio slot
+ *
+ * Le scadenze oltre un giro di ruota restano nello slot e vengono
+ * saltate finché il tick corrente non raggiunge 'expires'.
+ */
+typedef struct conn_timer {
+    struct conn_timer *prev;
+    struct conn_timer *next;
+    int fd;
+    conn_timer_kind_t kind;             // TIMER_NONE se non collegato
+    uint64_t expires;                   // Tick di scadenza
+} conn_timer_t;
+
+// Slot della ruota: liste circolari con sentinella
+static conn_timer_t wheel[TIMER_WHEEL_SLOTS];
+
+// Tabella indicizzata per fd: gli elementi vengono riutilizzati, mai liberati
+static conn_timer_t **timer_table = NULL;
+static size_t timer_table_size = 0;
+
+static pthread_mutex_t wheel_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool timers_enabled = false;
+static uint64_t wheel_start_ms;         // Istante del tick 0
+static uint64_t next_tick;              // Primo tick non ancora elaborato
+static uint64_t idle_ticks;             // connection_timeout in tick (0 = disattivato)
+static uint64_t read_ticks;             // read_timeout in tick (0 = disattivato)
+
+// ============================================================================
+// FUNZIONI DI SUPPORTO
+// ============================================================================
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static uint64_t current_tick(void) {
+    return (now_ms() - wheel_start_ms) / TIMER_TICK_MS;
+}
+
+static uint64_t seconds_to_ticks(int seconds) {
+    if (seconds <= 0) return 0;
+    return ((uint64_t)seconds * 1000 + TIMER_TICK_MS - 1) / TIMER_TICK_MS;
+}
+
+static const char *kind_name(conn_timer_kind_t kind) {
+    switch (kind) {
+        case TIMER_IDLE: return "inattività";
+        case TIMER_HEADER: return "lettura header";
+        case TIMER_PAYLOAD: return "lettura payload";
+        default: return "nessuno";
+    }
+}
+
+/**
+ * @note Richiede che wheel_lock sia già acquisito
+ */
+static void timer_unlink(conn_timer_t *timer) {
+    if (timer->kind == TIMER_NONE) return;
+    timer->prev->next = timer->next;
+    timer->next->prev = timer->prev;
+    timer->prev = timer->next = NULL;
+    timer->kind = TIMER_NONE;
+}
+
+/**
+ * @note Richiede che wheel_lock sia già acquisito
+ */
+static void timer_link(conn_timer_t *timer, conn_timer_kind_t kind, uint64_t expires) {
+    conn_timer_t *slot = &wheel[expires & (TIMER_WHEEL_SLOTS - 1)];
+    timer->kind = kind;
+    timer->expires = expires;
+    timer->prev = slot->prev;
+    timer->next = slot;
+    slot->prev->next = timer;
+    slot->prev = timer;
+}
+
+// ============================================================================
+// API PUBBLICA
+// ============================================================================
+
+int timers_init(void) {
+    idle_ticks = seconds_to_ticks(server_config.connection_timeout);
+    read_ticks = seconds_to_ticks(server_config.read_timeout);
+    if (idle_ticks == 0 && read_ticks == 0) {
+        LOG_INFO("Timeout delle connessioni disattivati");
+        return 0;
+    }
+
+    struct rlimit limit;
+    size_t size = TIMERS_MAX_FDS;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY &&
+        limit.rlim_cur < TIMERS_MAX_FDS) {
+        size = limit.rlim_cur;
+    }
+
+    timer_table = calloc(size, sizeof(conn_timer_t *));
+    if (!timer_table) {
+        LOG_ERROR("Errore allocazione tabella dei timer (%zu fd)", size);
+        return -1;
+    }
+    timer_table_size = size;
+
+    for (int i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+        wheel[i].prev = wheel[i].next = &wheel[i];
+    }
+    wheel_start_ms = now_ms();
+    next_tick = 0;
+    timers_enabled = true;
+
+    LOG_INFO("Timer wheel inizializzata (%d slot da %d ms): connection_timeout=%d s, read_timeout=%d s",
+             TIMER_WHEEL_SLOTS, TIMER_TICK_MS, server_config.connection_timeout,
+             server_config.read_timeout);
+    return 0;
+}
+
+/**
+ * Timer del fd, allocato al primo uso
+ *
+ * @note Richiede che wheel_lock sia già acquisito
+ */
+static conn_timer_t *timer_of_fd(int fd) {
+    conn_timer_t *timer = timer_table[fd];
+    if (!timer) {
+        timer = calloc(1, sizeof(conn_timer_t));
+        if (!timer) {
+            LOG_ERROR("Errore allocazione timer per FD=%d", fd);
+            return NULL;
+        }
+        timer->fd = fd;
+        timer_table[fd] = timer;
+    }
+    return timer;
+}
+
+/**
+ * @note Richiede che wheel_lock sia già acquisito
+ */
+static void timer_rearm(conn_timer_t *timer, conn_timer_kind_t kind) {
+    uint64_t ticks = (kind == TIMER_IDLE) ? idle_ticks : read_ticks;
+    timer_unlink(timer);
+    if (ticks > 0) {
+        // +1: il tick corrente è già in parte trascorso, la scadenza non va anticipata
+        timer_link(timer, kind, current_tick() + ticks + 1);
+    }
+}
+
+void timers_arm(int fd, conn_timer_kind_t kind) {
+    if (!timers_enabled) return;
+    if (kind == TIMER_NONE) {
+        timers_cancel(fd);
+        return;
+    }
+    if (fd < 0 || (size_t)fd >= timer_table_size) {
+        LOG_ERROR("FD=%d oltre la tabella dei timer", fd);
+        return;
+    }
+
+    pthread_mutex_lock(&wheel_lock);
+    conn_timer_t *timer = timer_of_fd(fd);
+    // Lettura già sorvegliata: la scadenza non si sposta
+    if (timer && (kind == TIMER_IDLE || timer->kind != kind)) {
+        timer_rearm(timer, kind);
+    }
+    pthread_mutex_unlock(&wheel_lock);
+}
+
+void timers_watch_idle(int fd, bool watch) {
+    if (!timers_enabled || fd < 0 || (size_t)fd >= timer_table_size) return;
+
+    pthread_mutex_lock(&wheel_lock);
+    conn_timer_t *timer = timer_of_fd(fd);
+    if (timer && watch && timer->kind == TIMER_NONE) {
+        timer_rearm(timer, TIMER_IDLE);
+    } else if (timer && !watch && timer->kind == TIMER_IDLE) {
+        timer_unlink(timer);
+    }
+    pthread_mutex_unlock(&wheel_lock);
+}
+
+void timers_cancel(int fd) {
+    if (!timers_enabled || fd < 0 || (size_t)fd >= timer_table_size) return;
+
+    pthread_mutex_lock(&wheel_lock);
+    conn_timer_t *timer = timer_table[fd];
+    if (timer) {
+        timer_unlink(timer);
+    }
+    pthread_mutex_unlock(&wheel_lock);
+}
+
+int timers_expire(void) {
+    if (!timers_enabled) return -1;
+
+    pthread_mutex_lock(&wheel_lock);
+    uint64_t now = current_tick();
+
+    // Dopo una lunga pausa basta un giro completo per visitare ogni slot
+    uint64_t steps = now + 1 - next_tick;
+    if (now + 1 < next_tick) steps = 0;
+    if (steps > TIMER_WHEEL_SLOTS) steps = TIMER_WHEEL_SLOTS;
+
+    for (uint64_t i = 0; i < steps; i++) {
+        conn_timer_t *slot = &wheel[(next_tick + i) & (TIMER_WHEEL_SLOTS - 1)];
+        conn_timer_t *timer = slot->next;
+        while (timer != slot) {
+            conn_timer_t *next = timer->next;
+            if (timer->expires <= now) {
+                LOG_INFO("Timeout di %s per FD=%d, disconnessione", kind_name(timer->kind), timer->fd);
+                timer_unlink(timer);
+                // Il percorso di lettura vedrà EOF ed eseguirà handle_disconnect()
+                if (shutdown(timer->fd, SHUT_RDWR) < 0 && errno != ENOTCONN) {
+                    LOG_WARN("shutdown per timeout fallito su FD=%d: %s", timer->fd, strerror(errno));
+                }
+            }
+            timer = next;
+        }
+    }
+    if (next_tick <= now) next_tick = now + 1;
+    pthread_mutex_unlock(&wheel_lock);
+
+    uint64_t next_ms = wheel_start_ms + next_tick * TIMER_TICK_MS;
+    uint64_t current_ms = now_ms();
+    return next_ms > current_ms ? (int)(next_ms - current_ms) : 0;
+}
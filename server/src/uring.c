@@ -0,0 +1,734 @@
+#include "uring.h"
+#include "reactor.h"
+#include "server.h"
+#include "outbound.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#define URING_ENTRIES 256               // Dimensione della submission queue
+#define URING_BUF_COUNT 256             // Buffer forniti al kernel (potenza di 2)
+#define URING_BUF_SIZE 4096             // Dimensione di ogni buffer di ricezione
+#define URING_BGID 0                    // ID del gruppo di buffer
+
+// Tipo di operazione nei 2 bit bassi di user_data (i puntatori sono allineati);
+// per TAG_ACCEPT i bit restanti contengono il fd del socket in ascolto
+#define TAG_ACCEPT 0
+#define TAG_RECV 1
+#define TAG_SEND 2
+#define TAG_MASK 3
+
+// ============================================================================
+// STRUTTURE DATI
+// ============================================================================
+
+struct uring_conn;
+
+/**
+ * Messaggio in uscita: header e payload inviati con due SQE collegate
+ */
+typedef struct tx_frame {
+    struct tx_frame *next;              // Prossimo messaggio in coda (o nella free list)
+    struct uring_conn *conn;            // Connessione destinataria
+    int pending;                        // Completamenti ancora attesi (1 o 2)
+    size_t payload_size;                // Dimensione del payload
+    protocol_header_t header;           // Header già in network byte order
+    uint8_t payload[MAX_MESSAGE_SIZE];  // Copia del payload
+} tx_frame_t;
+
+/**
+ * Connessione gestita dal ring
+ *
+ * Una connessione in chiusura viene liberata solo quando la recv
+ * multishot è terminata e non ci sono invii in volo.
+ */
+typedef struct uring_conn {
+    connection_t base;                  // fd e buffer di ricezione (comuni al reactor)
+    bool closing;                       // Client già rimosso, in attesa di chiusura
+    bool recv_armed;                    // Recv multishot ancora attiva
+    bool tx_inflight;                   // Il primo messaggio della coda è nel kernel
+    bool tx_overflowed;                 // Client troppo lento: invii scartati
+    size_t tx_depth;                    // Messaggi in coda
+    tx_frame_t *tx_head;                // Coda dei messaggi da inviare
+    tx_frame_t *tx_tail;
+} uring_conn_t;
+
+typedef struct {
+    int ring_fd;
+    int listen_fd;
+
+    // Submission queue
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned sq_entries;
+    unsigned sq_local_tail;             // Tail non ancora pubblicata al kernel
+    unsigned to_submit;
+    struct io_uring_sqe *sqes;
+
+    // Completion queue
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+
+    // Buffer ring per le ricezioni
+    struct io_uring_buf_ring *buf_ring;
+    uint8_t *buf_base;
+    unsigned short buf_tail;
+
+    // Connessioni indicizzate per fd (accedute solo dal thread del ring)
+    uring_conn_t **conns;
+    int conns_cap;
+
+    tx_frame_t *free_frames;            // Messaggi riutilizzabili
+} uring_t;
+
+static uring_t ring;
+static __thread bool ring_thread = false;
+
+// ============================================================================
+// SYSCALL E GESTIONE DEL RING
+// ============================================================================
+
+static int sys_io_uring_setup(unsigned entries, struct io_uring_params *p) {
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int sys_io_uring_register(int fd, unsigned opcode, void *arg, unsigned nr_args) {
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+/**
+ * Pubblica le SQE preparate e, se richiesto, attende completamenti
+ */
+static int uring_enter(unsigned wait_nr) {
+    __atomic_store_n(ring.sq_tail, ring.sq_local_tail, __ATOMIC_RELEASE);
+
+    int ret = sys_io_uring_enter(ring.ring_fd, ring.to_submit, wait_nr,
+                                 wait_nr ? IORING_ENTER_GETEVENTS : 0);
+    if (ret > 0) {
+        ring.to_submit -= ret;
+    }
+    return ret;
+}
+
+/**
+ * Garantisce almeno 'count' SQE libere (sottomettendo quelle pronte)
+ */
+static void uring_reserve(unsigned count) {
+    unsigned head = __atomic_load_n(ring.sq_head, __ATOMIC_ACQUIRE);
+    if (ring.sq_local_tail - head + count > ring.sq_entries) {
+        uring_enter(0);
+    }
+}
+
+static struct io_uring_sqe *uring_get_sqe(void) {
+    uring_reserve(1);
+
+    unsigned idx = ring.sq_local_tail & *ring.sq_mask;
+    struct io_uring_sqe *sqe = &ring.sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    ring.sq_array[idx] = idx;
+    ring.sq_local_tail++;
+    ring.to_submit++;
+    return sqe;
+}
+
+/**
+ * Restituisce un buffer di ricezione al kernel
+ * Si scrivono solo addr/len/bid: bufs[0].resv coincide con la tail del ring
+ */
+static void uring_recycle_buffer(unsigned short bid) {
+    struct io_uring_buf *buf = &ring.buf_ring->bufs[ring.buf_tail & (URING_BUF_COUNT - 1)];
+    buf->addr = (uint64_t)(uintptr_t)(ring.buf_base + (size_t)bid * URING_BUF_SIZE);
+    buf->len = URING_BUF_SIZE;
+    buf->bid = bid;
+    ring.buf_tail++;
+    __atomic_store_n(&ring.buf_ring->tail, ring.buf_tail, __ATOMIC_RELEASE);
+}
+
+/**
+ * Verifica che il kernel supporti le operazioni usate dal motore
+ *
+ * I buffer ring (5.19) non bastano: la recv multishot arriva solo con il
+ * 6.0, e senza di essa ogni ricezione completerebbe con -EINVAL. Oltre al
+ * probe degli opcode si sottomette quindi una recv multishot di prova su
+ * una coppia di socket. L'accept multishot è del 5.19, come i buffer ring
+ * già registrati.
+ *
+ * @return 0 se tutto è supportato, -1 altrimenti
+ */
+static int uring_probe(void) {
+    static const int needed_ops[] = { IORING_OP_ACCEPT, IORING_OP_RECV, IORING_OP_SEND };
+
+    size_t probe_size = sizeof(struct io_uring_probe) + IORING_OP_LAST * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe *probe = calloc(1, probe_size);
+    if (!probe) {
+        LOG_ERROR("Errore allocazione memoria per il probe di io_uring");
+        return -1;
+    }
+    if (sys_io_uring_register(ring.ring_fd, IORING_REGISTER_PROBE, probe, IORING_OP_LAST) < 0) {
+        LOG_WARN("Probe io_uring non supportato dal kernel: %s", strerror(errno));
+        free(probe);
+        return -1;
+    }
+    for (size_t i = 0; i < sizeof(needed_ops) / sizeof(needed_ops[0]); i++) {
+        int op = needed_ops[i];
+        if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+            LOG_WARN("Operazione io_uring %d non supportata dal kernel", op);
+            free(probe);
+            return -1;
+        }
+    }
+    free(probe);
+
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) < 0) {
+        LOG_WARN("socketpair per la recv di prova fallita: %s", strerror(errno));
+        return -1;
+    }
+
+    struct io_uring_sqe *sqe = uring_get_sqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = sv[0];
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = URING_BGID;
+    sqe->user_data = TAG_RECV;          // Nessuna connessione: i completamenti si leggono qui
+
+    // Un byte e poi EOF: la recv termina da sola (o subito, con -EINVAL)
+    if (write(sv[1], "x", 1) != 1) {
+        LOG_WARN("Scrittura della recv di prova fallita: %s", strerror(errno));
+    }
+    close(sv[1]);
+
+    int error = 0;
+    bool done = false;
+    while (!done) {
+        if (uring_enter(1) < 0 && errno != EINTR) {
+            error = -errno;
+            break;
+        }
+        unsigned head = *ring.cq_head;
+        unsigned tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            struct io_uring_cqe *cqe = &ring.cqes[head & *ring.cq_mask];
+            if (cqe->res < 0 && error == 0) {
+                error = cqe->res;
+            }
+            if (cqe->flags & IORING_CQE_F_BUFFER) {
+                uring_recycle_buffer(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+            }
+            if (!(cqe->flags & IORING_CQE_F_MORE)) {
+                done = true;
+            }
+            head++;
+        }
+        __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+    }
+    close(sv[0]);
+
+    if (error < 0) {
+        LOG_WARN("Recv multishot io_uring non supportata dal kernel: %s", strerror(-error));
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Crea il ring e registra il buffer ring
+ *
+ * @return 0 se successo, -1 se il kernel non supporta io_uring, i buffer ring o
+ *         la recv multishot
+ */
+static int uring_setup(int server_fd) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    ring.listen_fd = server_fd;
+    ring.ring_fd = sys_io_uring_setup(URING_ENTRIES, &params);
+    if (ring.ring_fd < 0) {
+        LOG_WARN("io_uring_setup non disponibile: %s", strerror(errno));
+        return -1;
+    }
+
+    size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap && cq_size > sq_size) {
+        sq_size = cq_size;
+    }
+
+    // Ogni errore da qui in poi libera quanto già mappato o allocato (vedi 'fail')
+    size_t sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    size_t buf_ring_size = URING_BUF_COUNT * sizeof(struct io_uring_buf);
+    uint8_t *cq_ptr = MAP_FAILED;
+    ring.sqes = MAP_FAILED;
+    ring.buf_ring = MAP_FAILED;
+    ring.buf_base = NULL;
+
+    uint8_t *sq_ptr = mmap(NULL, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                           ring.ring_fd, IORING_OFF_SQ_RING);
+    if (sq_ptr == MAP_FAILED) {
+        LOG_WARN("mmap della submission queue fallita: %s", strerror(errno));
+        goto fail;
+    }
+
+    if (single_mmap) {
+        cq_ptr = sq_ptr;
+    } else {
+        cq_ptr = mmap(NULL, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring.ring_fd, IORING_OFF_CQ_RING);
+        if (cq_ptr == MAP_FAILED) {
+            LOG_WARN("mmap della completion queue fallita: %s", strerror(errno));
+            goto fail;
+        }
+    }
+
+    ring.sqes = mmap(NULL, sqes_size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, ring.ring_fd, IORING_OFF_SQES);
+    if (ring.sqes == MAP_FAILED) {
+        LOG_WARN("mmap delle SQE fallita: %s", strerror(errno));
+        goto fail;
+    }
+
+    ring.sq_head = (unsigned *)(sq_ptr + params.sq_off.head);
+    ring.sq_tail = (unsigned *)(sq_ptr + params.sq_off.tail);
+    ring.sq_mask = (unsigned *)(sq_ptr + params.sq_off.ring_mask);
+    ring.sq_array = (unsigned *)(sq_ptr + params.sq_off.array);
+    ring.sq_entries = params.sq_entries;
+    ring.sq_local_tail = *ring.sq_tail;
+
+    ring.cq_head = (unsigned *)(cq_ptr + params.cq_off.head);
+    ring.cq_tail = (unsigned *)(cq_ptr + params.cq_off.tail);
+    ring.cq_mask = (unsigned *)(cq_ptr + params.cq_off.ring_mask);
+    ring.cqes = (struct io_uring_cqe *)(cq_ptr + params.cq_off.cqes);
+
+    // Buffer ring: memoria condivisa con il kernel per le recv con buffer select
+    ring.buf_ring = mmap(NULL, buf_ring_size, PROT_READ | PROT_WRITE,
+                         MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    ring.buf_base = malloc((size_t)URING_BUF_COUNT * URING_BUF_SIZE);
+    if (ring.buf_ring == MAP_FAILED || !ring.buf_base) {
+        LOG_ERROR("Errore allocazione memoria per i buffer di io_uring");
+        goto fail;
+    }
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)(uintptr_t)ring.buf_ring;
+    reg.ring_entries = URING_BUF_COUNT;
+    reg.bgid = URING_BGID;
+    if (sys_io_uring_register(ring.ring_fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        LOG_WARN("Buffer ring io_uring non supportati dal kernel: %s", strerror(errno));
+        goto fail;
+    }
+
+    ring.buf_tail = 0;
+    for (unsigned short bid = 0; bid < URING_BUF_COUNT; bid++) {
+        uring_recycle_buffer(bid);
+    }
+
+    // Il motore usa recv multishot: senza, meglio il fallback che client disconnessi
+    if (uring_probe() < 0) {
+        goto fail;
+    }
+
+    return 0;
+
+fail:
+    // Il kernel rilascia il ring solo quando non restano né il fd né le sue mappature
+    free(ring.buf_base);
+    ring.buf_base = NULL;
+    if (ring.buf_ring != MAP_FAILED) munmap(ring.buf_ring, buf_ring_size);
+    if (ring.sqes != MAP_FAILED) munmap(ring.sqes, sqes_size);
+    if (cq_ptr != MAP_FAILED && cq_ptr != sq_ptr) munmap(cq_ptr, cq_size);
+    if (sq_ptr != MAP_FAILED) munmap(sq_ptr, sq_size);
+    ring.buf_ring = NULL;
+    ring.sqes = NULL;
+    close(ring.ring_fd);
+    ring.ring_fd = -1;
+    return -1;
+}
+
+// ============================================================================
+// CONNESSIONI
+// ============================================================================
+
+static uring_conn_t *conn_lookup(int fd) {
+    if (fd < 0 || fd >= ring.conns_cap) return NULL;
+    return ring.conns[fd];
+}
+
+static int conn_register(uring_conn_t *conn) {
+    int fd = conn->base.fd;
+    if (fd >= ring.conns_cap) {
+        int new_cap = ring.conns_cap ? ring.conns_cap : 64;
+        while (new_cap <= fd) new_cap *= 2;
+
+        uring_conn_t **grown = realloc(ring.conns, new_cap * sizeof(uring_conn_t *));
+        if (!grown) return -1;
+        memset(grown + ring.conns_cap, 0, (new_cap - ring.conns_cap) * sizeof(uring_conn_t *));
+        ring.conns = grown;
+        ring.conns_cap = new_cap;
+    }
+    ring.conns[fd] = conn;
+    return 0;
+}
+
+static void arm_accept(int listen_fd) {
+    struct io_uring_sqe *sqe = uring_get_sqe();
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = listen_fd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    sqe->user_data = ((uint64_t)listen_fd << 2) | TAG_ACCEPT;
+}
+
+static void arm_recv(uring_conn_t *conn) {
+    struct io_uring_sqe *sqe = uring_get_sqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = conn->base.fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = URING_BGID;
+    sqe->user_data = (uint64_t)(uintptr_t)conn | TAG_RECV;
+    conn->recv_armed = true;
+}
+
+/**
+ * Sottomette il primo messaggio in coda: header e payload come catena
+ * IOSQE_IO_LINK, con MSG_WAITALL per far completare al kernel gli invii parziali
+ */
+static void submit_frame(uring_conn_t *conn) {
+    tx_frame_t *frame = conn->tx_head;
+    uring_reserve(2); // La catena non deve essere spezzata tra due submit
+
+    struct io_uring_sqe *sqe = uring_get_sqe();
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = conn->base.fd;
+    sqe->addr = (uint64_t)(uintptr_t)&frame->header;
+    sqe->len = sizeof(protocol_header_t);
+    sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+    sqe->user_data = (uint64_t)(uintptr_t)frame | TAG_SEND;
+    frame->pending = 1;
+
+    if (frame->payload_size > 0) {
+        sqe->flags |= IOSQE_IO_LINK;
+
+        sqe = uring_get_sqe();
+        sqe->opcode = IORING_OP_SEND;
+        sqe->fd = conn->base.fd;
+        sqe->addr = (uint64_t)(uintptr_t)frame->payload;
+        sqe->len = frame->payload_size;
+        sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+        sqe->user_data = (uint64_t)(uintptr_t)frame | TAG_SEND;
+        frame->pending = 2;
+    }
+
+    conn->tx_inflight = true;
+}
+
+static void release_frame(tx_frame_t *frame) {
+    frame->next = ring.free_frames;
+    ring.free_frames = frame;
+}
+
+/**
+ * Libera la connessione quando il kernel non ha più operazioni in volo su di essa
+ */
+static void conn_maybe_free(uring_conn_t *conn) {
+    if (!conn->closing || conn->recv_armed || conn->tx_inflight) return;
+
+    int client_fd = conn->base.fd;
+    while (conn->tx_head) {
+        tx_frame_t *next = conn->tx_head->next;
+        release_frame(conn->tx_head);
+        conn->tx_head = next;
+    }
+
+    ring.conns[client_fd] = NULL;
+    close(client_fd);
+    free(conn);
+
+    printf("Client FD=%d disconnesso e rimosso.\n", client_fd);
+    LOG_INFO("Client FD=%d disconnesso e rimosso", client_fd);
+}
+
+/**
+ * Rimuove il client dallo stato del server e avvia la chiusura
+ *
+ * Lo shutdown viene rimandato finché la coda di invio non è vuota,
+ * così la risposta a MSG_QUIT arriva comunque al client.
+ */
+static void conn_begin_close(uring_conn_t *conn) {
+    if (conn->closing) return;
+    conn->closing = true;
+
+    pthread_mutex_lock(&server_state.clients_lock);
+    remove_client(conn->base.fd);
+    pthread_mutex_unlock(&server_state.clients_lock);
+
+    if (!conn->tx_head) {
+        shutdown(conn->base.fd, SHUT_RDWR); // Termina la recv multishot
+    }
+}
+
+// ============================================================================
+// GESTIONE DEI COMPLETAMENTI
+// ============================================================================
+
+static void on_accept(int listen_fd, int res, unsigned flags) {
+    if (!(flags & IORING_CQE_F_MORE)) {
+        arm_accept(listen_fd); // Il kernel ha disattivato l'accept multishot
+    }
+
+    if (res < 0) {
+        LOG_ERROR("Accept fallito: %s", strerror(-res));
+        return;
+    }
+
+    int client_fd = res;
+    pthread_mutex_lock(&server_state.clients_lock);
+    int client_idx = add_client(client_fd);
+    int num_clients = server_state.num_clients;
+    pthread_mutex_unlock(&server_state.clients_lock);
+
+    if (client_idx < 0) {
+        if (client_idx == -1) {
+            reject_client_server_full(client_fd, num_clients);
+        } else {
+            close(client_fd); // fd oltre l'indice: il server non è pieno (causa nel log)
+        }
+        return;
+    }
+
+    uring_conn_t *conn = calloc(1, sizeof(uring_conn_t));
+    if (conn) {
+        conn->base.fd = client_fd;
+    }
+    if (!conn || conn_register(conn) < 0) {
+        LOG_ERROR("Errore allocazione memoria per connessione FD=%d", client_fd);
+        pthread_mutex_lock(&server_state.clients_lock);
+        remove_client(client_fd);
+        pthread_mutex_unlock(&server_state.clients_lock);
+        close(client_fd);
+        free(conn);
+        return;
+    }
+
+    arm_recv(conn);
+
+    printf("Nuovo client connesso! FD=%d\n", client_fd);
+    LOG_INFO("Nuova connessione client, FD=%d", client_fd);
+}
+
+/**
+ * Copia i byte ricevuti nel buffer della connessione e gestisce i messaggi
+ *
+ * @return true se la connessione resta aperta, false se va chiusa
+ */
+static bool conn_feed(uring_conn_t *conn, const uint8_t *data, size_t len) {
+    connection_t *base = &conn->base;
+
+    while (len > 0) {
+        // Dopo il dispatch resta al più un messaggio incompleto: c'è sempre spazio
+        size_t copied = protocol_decoder_feed(&base->decoder, data, len);
+        data += copied;
+        len -= copied;
+
+        if (!dispatch_decoded_messages(base->fd, &base->decoder)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void on_recv(uring_conn_t *conn, int res, unsigned flags) {
+    if (!(flags & IORING_CQE_F_MORE)) {
+        conn->recv_armed = false;
+    }
+
+    if (res > 0 && (flags & IORING_CQE_F_BUFFER)) {
+        unsigned short bid = flags >> IORING_CQE_BUFFER_SHIFT;
+        bool keep = conn->closing ||
+                    conn_feed(conn, ring.buf_base + (size_t)bid * URING_BUF_SIZE, res);
+        uring_recycle_buffer(bid);
+
+        if (!keep) {
+            conn_begin_close(conn); // MSG_QUIT o payload invalido
+        }
+    } else if (res == -ENOBUFS) {
+        LOG_WARN("Buffer di ricezione io_uring esauriti (FD=%d)", conn->base.fd);
+    } else if (!conn->closing) {
+        if (res == 0) {
+            LOG_INFO("Client FD=%d disconnesso (connessione chiusa)", conn->base.fd);
+        } else {
+            LOG_WARN("Errore ricezione da FD=%d: %s", conn->base.fd, strerror(-res));
+        }
+        handle_disconnect(conn->base.fd);
+        conn_begin_close(conn);
+    }
+
+    if (!conn->recv_armed && !conn->closing) {
+        arm_recv(conn);
+    }
+    conn_maybe_free(conn);
+}
+
+static void on_send(tx_frame_t *frame, int res) {
+    uring_conn_t *conn = frame->conn;
+
+    if (res < 0 && res != -ECANCELED) {
+        LOG_WARN("Errore invio a FD=%d: %s", conn->base.fd, strerror(-res));
+    }
+    if (--frame->pending > 0) return;
+
+    // Catena completata: passa al prossimo messaggio della stessa connessione
+    conn->tx_head = frame->next;
+    if (!conn->tx_head) conn->tx_tail = NULL;
+    conn->tx_inflight = false;
+    conn->tx_depth--;
+    release_frame(frame);
+
+    if (conn->tx_head) {
+        submit_frame(conn);
+    } else if (conn->closing) {
+        shutdown(conn->base.fd, SHUT_RDWR);
+    }
+    conn_maybe_free(conn);
+}
+
+static void handle_cqe(uint64_t user_data, int res, unsigned flags) {
+    void *ptr = (void *)(uintptr_t)(user_data & ~(uint64_t)TAG_MASK);
+
+    switch (user_data & TAG_MASK) {
+        case TAG_ACCEPT:
+            on_accept((int)(user_data >> 2), res, flags);
+            break;
+        case TAG_RECV:
+            on_recv(ptr, res, flags);
+            break;
+        case TAG_SEND:
+            on_send(ptr, res);
+            break;
+    }
+}
+
+// ============================================================================
+// API PUBBLICA
+// ============================================================================
+
+bool uring_is_active(void) {
+    return ring_thread;
+}
+
+ssize_t uring_send(int client_fd, uint8_t msg_type, const void *payload, size_t payload_size) {
+    uring_conn_t *conn = conn_lookup(client_fd);
+    if (!conn || conn->closing) {
+        LOG_DEBUG("Invio scartato: FD=%d non più connesso", client_fd);
+        return -1;
+    }
+    if (payload_size > MAX_MESSAGE_SIZE) {
+        LOG_ERROR("Payload troppo grande per FD=%d: %zu bytes", client_fd, payload_size);
+        return -1;
+    }
+    if (conn->tx_overflowed) {
+        return -1;
+    }
+
+    size_t max_depth = server_config.max_send_queue > 0 ?
+                       (size_t)server_config.max_send_queue : OUTBOUND_DEFAULT_MAX_FRAMES;
+    if (conn->tx_depth >= max_depth) {
+        // Client troppo lento: la recv terminerà e avvierà la disconnessione
+        LOG_WARN("Coda di uscita piena per FD=%d (%zu messaggi), disconnessione",
+                 client_fd, conn->tx_depth);
+        conn->tx_overflowed = true;
+        shutdown(client_fd, SHUT_RDWR);
+        return -1;
+    }
+
+    tx_frame_t *frame = ring.free_frames;
+    if (frame) {
+        ring.free_frames = frame->next;
+    } else {
+        frame = malloc(sizeof(tx_frame_t));
+        if (!frame) {
+            LOG_ERROR("Errore allocazione memoria per messaggio a FD=%d", client_fd);
+            return -1;
+        }
+        count_request_alloc();
+    }
+
+    frame->next = NULL;
+    frame->conn = conn;
+    frame->payload_size = payload ? payload_size : 0;
+    protocol_init_header(&frame->header, msg_type, (uint16_t)frame->payload_size, 0);
+    if (frame->payload_size > 0) {
+        memcpy(frame->payload, payload, frame->payload_size);
+    }
+
+    if (conn->tx_tail) {
+        conn->tx_tail->next = frame;
+    } else {
+        conn->tx_head = frame;
+    }
+    conn->tx_tail = frame;
+    conn->tx_depth++;
+
+    if (!conn->tx_inflight) {
+        submit_frame(conn);
+    }
+
+    return sizeof(protocol_header_t) + frame->payload_size;
+}
+
+int uring_run(int server_fd) {
+    if (uring_setup(server_fd) < 0) {
+        return -1;
+    }
+
+    ring_thread = true;
+    arm_accept(ring.listen_fd);
+    if (server_state.unix_fd >= 0) {
+        arm_accept(server_state.unix_fd); // Connessioni locali sullo stesso ring
+    }
+
+    LOG_INFO("Motore io_uring avviato (%u SQE, %d buffer da %d bytes)",
+             ring.sq_entries, URING_BUF_COUNT, URING_BUF_SIZE);
+    printf("Motore io_uring avviato\n");
+
+    while (1) {
+        // Una sola syscall sottomette tutte le SQE preparate e attende completamenti
+        if (uring_enter(1) < 0 && errno != EINTR && errno != EBUSY) {
+            LOG_ERROR("io_uring_enter fallito: %s", strerror(errno));
+            continue;
+        }
+
+        unsigned head = *ring.cq_head;
+        unsigned tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            struct io_uring_cqe *cqe = &ring.cqes[head & *ring.cq_mask];
+            uint64_t user_data = cqe->user_data;
+            int res = cqe->res;
+            unsigned flags = cqe->flags;
+
+            head++;
+            __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+
+            handle_cqe(user_data, res, flags);
+        }
+    }
+
+    return 0;
+}
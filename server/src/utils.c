@@ -45,10 +45,28 @@ int load_config(const char* config_file, ServerConfig* config) {
             config->port = atoi(value);
         } else if (strcmp(key, "backlog_size") == 0) {
             config->backlog_size = atoi(value);
+        } else if (strcmp(key, "unix_socket") == 0) {
+            strncpy(config->unix_socket, value, sizeof(config->unix_socket) - 1);
+        } else if (strcmp(key, "tcp_fastopen") == 0) {
+            config->tcp_fastopen = atoi(value);
+        } else if (strcmp(key, "defer_accept") == 0) {
+            config->defer_accept = atoi(value);
         } else if (strcmp(key, "max_clients") == 0) {
             config->max_clients = atoi(value);
         } else if (strcmp(key, "max_games") == 0) {
             config->max_games = atoi(value);
+        } else if (strcmp(key, "io_mode") == 0) {
+            strncpy(config->io_mode, value, sizeof(config->io_mode) - 1);
+        } else if (strcmp(key, "io_threads") == 0) {
+            config->io_threads = atoi(value);
+        } else if (strcmp(key, "worker_threads") == 0) {
+            config->worker_threads = atoi(value);
+        } else if (strcmp(key, "shards") == 0) {
+            config->shards = atoi(value);
+        } else if (strcmp(key, "actor_shards") == 0) {
+            config->actor_shards = atoi(value);
+        } else if (strcmp(key, "max_send_queue") == 0) {
+            config->max_send_queue = atoi(value);
         } else if (strcmp(key, "connection_timeout") == 0) {
             config->connection_timeout = atoi(value);
         } else if (strcmp(key, "read_timeout") == 0) {
@@ -70,8 +88,17 @@ void print_config(const ServerConfig* config) {
     printf("Server IP: %s\n", config->server_ip);
     printf("Porta: %d\n", config->port);
     printf("Backlog: %d\n", config->backlog_size);
+    printf("Socket unix: %s\n", config->unix_socket[0] ? config->unix_socket : "(disattivato)");
+    printf("TCP Fast Open: %d\n", config->tcp_fastopen);
+    printf("Defer accept: %d sec\n", config->defer_accept);
     printf("Max client: %d\n", config->max_clients);
     printf("Max partite: %d\n", config->max_games);
+    printf("Modalità I/O: %s\n", config->io_mode[0] ? config->io_mode : "threads");
+    printf("Thread I/O: %d\n", config->io_threads);
+    printf("Worker: %d\n", config->worker_threads);
+    printf("Shard epoll: %d\n", config->shards);
+    printf("Shard actors: %d\n", config->actor_shards);
+    printf("Coda di uscita massima: %d\n", config->max_send_queue);
     printf("Timeout connessione: %d sec\n", config->connection_timeout);
     printf("Timeout lettura: %d sec\n", config->read_timeout);
     printf("Livello log: %s\n", config->log_level);
@@ -79,6 +106,15 @@ void print_config(const ServerConfig* config) {
     printf("==================================\n");
 }
 
+// Converte la stringa io_mode in enum
+IoMode get_io_mode_from_string(const char* mode_str) {
+    if (strcmp(mode_str, "epoll") == 0) return IO_MODE_EPOLL;
+    if (strcmp(mode_str, "uring") == 0) return IO_MODE_URING;
+    if (strcmp(mode_str, "pool") == 0) return IO_MODE_POOL;
+    if (strcmp(mode_str, "actors") == 0) return IO_MODE_ACTORS;
+    return IO_MODE_THREADS; // Default
+}
+
 // Inizializza la configurazione di logging dal server config
 void init_server_logging(void) {
     // Copia le impostazioni di logging dal server_config al log_config
@@ -90,4 +126,15 @@ void init_server_logging(void) {
     
     // Inizializza il sistema di logging condiviso
     init_logging();
-}
\ No newline at end of file
+}
+
+// Allocazioni sul percorso delle richieste
+static unsigned long request_allocs = 0;
+
+void count_request_alloc(void) {
+    __atomic_add_fetch(&request_allocs, 1, __ATOMIC_RELAXED);
+}
+
+unsigned long get_request_allocs(void) {
+    return __atomic_load_n(&request_allocs, __ATOMIC_RELAXED);
+}
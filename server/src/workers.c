@@ -0,0 +1,199 @@
+#include "workers.h"
+#include "server.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+
+#define DEQUE_INITIAL_CAPACITY 64
+
+// ============================================================================
+// STATO DEL POOL
+// ============================================================================
+
+/**
+ * Deque di un worker: buffer circolare che cresce al bisogno
+ *
+ * Il proprietario preleva dalla testa (ordine di arrivo), i ladri
+ * dalla coda. Il lock è per-deque: sottomissioni e furti su worker
+ * diversi non si contendono nulla.
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    void **tasks;
+    size_t capacity;
+    size_t head;                        // Indice del task più vecchio
+    size_t count;                       // Task presenti
+} worker_deque_t;
+
+static worker_deque_t *deques = NULL;
+static int num_deques = 0;
+static worker_task_fn task_fn = NULL;
+static unsigned int next_deque = 0;     // Round-robin delle sottomissioni
+
+// Task accodati e non ancora prelevati, worker in attesa
+static long pending_tasks = 0;
+static int idle_workers = 0;
+static pthread_mutex_t idle_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t idle_cond = PTHREAD_COND_INITIALIZER;
+
+// ============================================================================
+// OPERAZIONI SULLE DEQUE
+// ============================================================================
+
+/**
+ * @note Richiede che deque->lock sia già acquisito
+ */
+static int deque_grow(worker_deque_t *deque) {
+    size_t new_capacity = deque->capacity ? deque->capacity * 2 : DEQUE_INITIAL_CAPACITY;
+    void **tasks = malloc(new_capacity * sizeof(void *));
+    if (!tasks) return -1;
+
+    for (size_t i = 0; i < deque->count; i++) {
+        tasks[i] = deque->tasks[(deque->head + i) % deque->capacity];
+    }
+    free(deque->tasks);
+    deque->tasks = tasks;
+    deque->capacity = new_capacity;
+    deque->head = 0;
+    return 0;
+}
+
+static int deque_push(worker_deque_t *deque, void *task) {
+    pthread_mutex_lock(&deque->lock);
+    if (deque->count == deque->capacity && deque_grow(deque) < 0) {
+        pthread_mutex_unlock(&deque->lock);
+        return -1;
+    }
+    deque->tasks[(deque->head + deque->count) % deque->capacity] = task;
+    deque->count++;
+    pthread_mutex_unlock(&deque->lock);
+    return 0;
+}
+
+/**
+ * Preleva il task più vecchio (usata dal proprietario della deque)
+ */
+static void *deque_pop_front(worker_deque_t *deque) {
+    void *task = NULL;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->count > 0) {
+        task = deque->tasks[deque->head];
+        deque->head = (deque->head + 1) % deque->capacity;
+        deque->count--;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return task;
+}
+
+/**
+ * Ruba il task più recente (usata dagli altri worker)
+ */
+static void *deque_steal_back(worker_deque_t *deque) {
+    void *task = NULL;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->count > 0) {
+        deque->count--;
+        task = deque->tasks[(deque->head + deque->count) % deque->capacity];
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return task;
+}
+
+// ============================================================================
+// THREAD WORKER
+// ============================================================================
+
+/**
+ * Cerca un task: prima nella propria deque, poi in quelle degli altri
+ */
+static void *find_task(int self) {
+    void *task = deque_pop_front(&deques[self]);
+
+    for (int i = 1; !task && i < num_deques; i++) {
+        task = deque_steal_back(&deques[(self + i) % num_deques]);
+    }
+
+    if (task) {
+        __atomic_sub_fetch(&pending_tasks, 1, __ATOMIC_SEQ_CST);
+    }
+    return task;
+}
+
+static void *worker_thread(void *arg) {
+    int self = (int)(intptr_t)arg;
+
+    while (1) {
+        void *task = find_task(self);
+        if (task) {
+            task_fn(task);
+            continue;
+        }
+
+        // Nessun task in nessuna deque: attendi una sottomissione
+        pthread_mutex_lock(&idle_lock);
+        __atomic_add_fetch(&idle_workers, 1, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&pending_tasks, __ATOMIC_SEQ_CST) <= 0) {
+            pthread_cond_wait(&idle_cond, &idle_lock);
+        }
+        __atomic_sub_fetch(&idle_workers, 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&idle_lock);
+    }
+
+    return NULL;
+}
+
+// ============================================================================
+// API PUBBLICA
+// ============================================================================
+
+int workers_start(int num_workers, worker_task_fn fn) {
+    if (num_workers <= 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        num_workers = cores > 0 ? (int)cores : 1;
+    }
+
+    deques = calloc(num_workers, sizeof(worker_deque_t));
+    if (!deques) {
+        LOG_ERROR("Errore allocazione deque del pool di worker");
+        return -1;
+    }
+    for (int i = 0; i < num_workers; i++) {
+        pthread_mutex_init(&deques[i].lock, NULL);
+    }
+    num_deques = num_workers;
+    task_fn = fn;
+
+    for (int i = 0; i < num_workers; i++) {
+        pthread_t tid;
+        if (pthread_create(&tid, NULL, worker_thread, (void *)(intptr_t)i) != 0) {
+            LOG_ERROR("Creazione worker %d fallita: %s", i, strerror(errno));
+            return -1;
+        }
+        pthread_detach(tid);
+    }
+
+    LOG_INFO("Pool di worker avviato con %d thread", num_workers);
+    return num_workers;
+}
+
+void workers_submit(void *task) {
+    unsigned int target = __atomic_fetch_add(&next_deque, 1, __ATOMIC_RELAXED) % num_deques;
+
+    if (deque_push(&deques[target], task) < 0) {
+        // Senza memoria per far crescere la deque il task non può andare perso
+        LOG_ERROR("ERRORE CRITICO: Impossibile accodare un task al worker %u", target);
+        exit(EXIT_FAILURE);
+    }
+
+    __atomic_add_fetch(&pending_tasks, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&idle_workers, __ATOMIC_SEQ_CST) > 0) {
+        pthread_mutex_lock(&idle_lock);
+        pthread_cond_signal(&idle_cond);
+        pthread_mutex_unlock(&idle_lock);
+    }
+}
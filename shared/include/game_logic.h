@@ -1,6 +1,7 @@
 #ifndef GAME_LOGIC_H
 #define GAME_LOGIC_H
 
+#include <stdint.h>
 #include "constants.h"  
 
 // ============================================================================
@@ -8,7 +9,9 @@
 // ============================================================================
 
 /**
- * Struttura per rappresentare una partita
+ * Partita in forma estesa, con nomi e tabellone leggibili
+ * 
+ * Usata dal client come copia locale da stampare con game_print_board().
  */
 typedef struct {
     char game_id[MAX_GAME_ID_LEN];      // ID univoco della partita
@@ -20,6 +23,37 @@ typedef struct {
     int winner;                         // -1=nessuno, 0=player[0], 1=player[1], 2=pareggio
 } game_state_t;
 
+/**
+ * Partita in forma compatta (12 byte), su cui lavorano le regole del gioco
+ * 
+ * Tabellone e stato stanno in una sola parola:
+ * - bit 0-17: tabellone, 2 bit per cella (0 vuota, 1 X, 2 O), cella i nei bit 2i e 2i+1
+ * - bit 18-21: mosse effettuate (0-9)
+ * - bit 22-23: stato (GAME_WAITING, GAME_IN_PROGRESS, GAME_FINISHED)
+ * - bit 24: giocatore di turno (0 o 1)
+ * - bit 25-26: vincitore + 1 (0=nessuno, 1=player[0], 2=player[1], 3=pareggio)
+ * 
+ * I giocatori sono ID assegnati da chi usa la partita (0 = nessuno): nomi
+ * e game_id restano fuori, così il server tiene una partita viva in una
+ * riga di cache.
+ */
+typedef struct {
+    uint32_t word;                      // Tabellone e stato (vedi sopra)
+    uint32_t players[2];                // ID dei giocatori [0]=creatore, [1]=joiner
+} game_packed_t;
+
+// Valori di una cella del tabellone compatto
+#define CELL_EMPTY 0u
+#define CELL_X 1u
+#define CELL_O 2u
+
+// Campi della parola di una partita compatta
+#define GAME_CELL(game, idx) (((game)->word >> (2 * (idx))) & 3u)
+#define GAME_MOVE_COUNT(game) ((int)(((game)->word >> 18) & 0xFu))
+#define GAME_STATUS(game) ((int)(((game)->word >> 22) & 3u))
+#define GAME_CURRENT_PLAYER(game) ((int)(((game)->word >> 24) & 1u))
+#define GAME_WINNER(game) ((int)(((game)->word >> 25) & 3u) - 1)
+
 // ============================================================================
 // FUNZIONI DI INIZIALIZZAZIONE
 // ============================================================================
@@ -27,23 +61,21 @@ typedef struct {
 /**
  * Inizializza una nuova partita
  * 
- * Crea una nuova partita con l'ID specificato, imposta il giocatore
- * creatore e inizializza il tabellone vuoto.
+ * Imposta il giocatore creatore e inizializza il tabellone vuoto.
  * 
- * @param game Puntatore alla struttura game_state_t da inizializzare
- * @param game_id ID univoco della partita
- * @param creator Nome del giocatore che crea la partita
+ * @param game Puntatore alla struttura game_packed_t da inizializzare
+ * @param creator ID del giocatore che crea la partita (diverso da 0)
  */
-void game_init(game_state_t *game, const char *game_id, const char *creator);
+void game_init(game_packed_t *game, uint32_t creator);
 
 /**
  * Aggiunge il secondo giocatore alla partita
  * 
- * @param game Puntatore alla struttura game_state_t
- * @param player_name Nome del giocatore che si unisce
- * @return 1 se successo, 0 se partita già piena
+ * @param game Puntatore alla struttura game_packed_t
+ * @param player ID del giocatore che si unisce
+ * @return 1 se successo, 0 se partita già piena o stesso giocatore del creatore
  */
-int game_add_player(game_state_t *game, const char *player_name);
+int game_add_player(game_packed_t *game, uint32_t player);
 
 // ============================================================================
 // FUNZIONI DI MOVIMENTO
@@ -55,12 +87,12 @@ int game_add_player(game_state_t *game, const char *player_name);
  * Verifica che la mossa sia valida (cella libera, turno corretto)
  * e aggiorna lo stato del gioco.
  * 
- * @param game Puntatore alla struttura game_state_t
+ * @param game Puntatore alla struttura game_packed_t
  * @param player_idx 0 o 1 (indice del giocatore)
  * @param position 1-9 (posizione sulla griglia)
  * @return 1 se mossa valida, 0 altrimenti
  */
-int game_make_move(game_state_t *game, int player_idx, int position);
+int game_make_move(game_packed_t *game, int player_idx, int position);
 
 // ============================================================================
 // FUNZIONI DI STATO
@@ -70,29 +102,29 @@ int game_make_move(game_state_t *game, int player_idx, int position);
  * Controlla se c'è un vincitore
  * 
  * Verifica tutte le combinazioni vincenti (righe, colonne, diagonali)
- * e determina se la partita è finita in pareggio.
+ * con un confronto a maschera sul tabellone compatto.
  * 
- * @param game Puntatore alla struttura game_state_t
- * @return -1=nessuno, 0=player[0], 1=player[1], 2=pareggio
+ * @param game Puntatore alla struttura game_packed_t
+ * @return -1=nessuno, 0=player[0], 1=player[1]
  */
-int game_check_winner(const game_state_t *game);
+int game_check_winner(const game_packed_t *game);
 
 /**
  * Verifica se la partita è terminata
  * 
- * @param game Puntatore alla struttura game_state_t
+ * @param game Puntatore alla struttura game_packed_t
  * @return 1 se terminata, 0 altrimenti
  */
-int game_is_finished(const game_state_t *game);
+int game_is_finished(const game_packed_t *game);
 
 /**
  * Verifica se è il turno del giocatore specificato
  * 
- * @param game Puntatore alla struttura game_state_t
- * @param player_name Nome del giocatore da verificare
+ * @param game Puntatore alla struttura game_packed_t
+ * @param player ID del giocatore da verificare
  * @return 1 se è il suo turno, 0 altrimenti
  */
-int game_is_player_turn(const game_state_t *game, const char *player_name);
+int game_is_player_turn(const game_packed_t *game, uint32_t player);
 
 // ============================================================================
 // FUNZIONI DI UTILITÀ
@@ -101,11 +133,10 @@ int game_is_player_turn(const game_state_t *game, const char *player_name);
 /**
  * Ottiene il simbolo del giocatore ('X' o 'O')
  * 
- * @param game Puntatore alla struttura game_state_t
  * @param player_idx Indice del giocatore (0 o 1)
- * @return 'X' per player[0], 'O' per player[1]
+ * @return 'X' per player[0], 'O' per player[1], '\0' se indice non valido
  */
-char game_get_player_symbol(const game_state_t *game, int player_idx);
+char game_get_player_symbol(int player_idx);
 
 /**
  * Stampa il tabellone a terminale con formattazione ANSI
@@ -121,11 +152,11 @@ void game_print_board(const game_state_t *game);
  * Copia lo stato del tabellone in un array di caratteri
  * 
  * Utilizzata per serializzare lo stato del tabellone nel protocollo
- * di comunicazione client-server.
+ * di comunicazione client-server (PLAYER_X, PLAYER_O o EMPTY_CELL).
  * 
- * @param game Puntatore alla struttura game_state_t
+ * @param game Puntatore alla struttura game_packed_t
  * @param board_str Array di 9 caratteri dove copiare il tabellone
  */
-void game_get_board_string(const game_state_t *game, char board_str[9]);
+void game_get_board_string(const game_packed_t *game, char board_str[9]);
 
 #endif 
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include "constants.h"
 #include <stdint.h>
+#include <stddef.h>
 #include <sys/types.h>
 
 // ============================================================================
@@ -316,6 +317,22 @@ typedef struct __attribute__((packed)) {
     uint8_t notify_type;    
 } notify_opponent_left_t;
 
+// ============================================================================
+// MESSAGGI IN USCITA
+// ============================================================================
+
+#define PROTOCOL_MAX_BATCH 32           // Messaggi per singola sendmsg in protocol_send_batch
+
+/**
+ * Descrittore di un messaggio da inviare (header costruito all'invio)
+ */
+typedef struct {
+    uint8_t msg_type;                   // Tipo di messaggio (MSG_*)
+    const void *payload;                // Payload (NULL se nessun payload)
+    size_t payload_size;                // Dimensione del payload in bytes
+    uint32_t seq_id;                    // ID sequenziale del messaggio
+} protocol_frame_t;
+
 // ============================================================================
 // FUNZIONI DI UTILITÀ - HEADER
 // ============================================================================
@@ -363,7 +380,9 @@ void protocol_header_to_host(protocol_header_t *header);
  * 
  * Crea e inizializza l'header del protocollo, lo invia insieme
  * al payload opzionale. Gestisce automaticamente la conversione
- * in network byte order e l'invio atomico.
+ * in network byte order. Header e payload partono con un'unica
+ * sendmsg (scatter/gather); gli invii parziali vengono ripresi
+ * finché il messaggio non è stato inviato per intero.
  * 
  * @param sockfd File descriptor del socket
  * @param msg_type Tipo di messaggio (MSG_*)
@@ -375,6 +394,20 @@ void protocol_header_to_host(protocol_header_t *header);
 ssize_t protocol_send(int sockfd, uint8_t msg_type, const void *payload, 
                      size_t payload_size, uint32_t seq_id);
 
+/**
+ * Invia più messaggi allo stesso socket con un'unica sendmsg
+ * 
+ * Header e payload di tutti i messaggi vengono raccolti in un solo
+ * vettore iovec (a blocchi di PROTOCOL_MAX_BATCH messaggi), riducendo
+ * le syscall quando più risposte/notifiche vanno allo stesso client.
+ * 
+ * @param sockfd File descriptor del socket
+ * @param frames Array di messaggi da inviare, in ordine
+ * @param count Numero di messaggi
+ * @return Numero di byte inviati totali, -1 se errore
+ */
+ssize_t protocol_send_batch(int sockfd, const protocol_frame_t *frames, size_t count);
+
 /**
  * Riceve l'header di un messaggio
  * 
@@ -401,6 +434,76 @@ ssize_t protocol_recv_header(int sockfd, protocol_header_t *header);
  */
 ssize_t protocol_recv_payload(int sockfd, void *buffer, size_t length);
 
+// ============================================================================
+// DECODER DI MESSAGGI IN RICEZIONE
+// ============================================================================
+
+// Spazio per due messaggi di dimensione massima: dopo la compattazione
+// resta sempre posto per un messaggio completo
+#define PROTOCOL_DECODER_SIZE (2 * (sizeof(protocol_header_t) + MAX_MESSAGE_SIZE))
+
+/**
+ * Buffer di ricezione con decodifica incrementale dei messaggi
+ * 
+ * Una singola recv() legge tutti i byte disponibili (anche più messaggi
+ * in pipeline); protocol_decoder_next() restituisce poi un messaggio
+ * completo alla volta, con il payload che punta direttamente nel buffer.
+ */
+typedef struct {
+    uint8_t buf[PROTOCOL_DECODER_SIZE];     // Byte ricevuti
+    size_t start;                           // Primo byte non ancora consumato
+    size_t end;                             // Fine dei byte validi
+} protocol_decoder_t;
+
+/**
+ * Inizializza (o svuota) un decoder
+ * 
+ * @param decoder Puntatore al decoder
+ */
+void protocol_decoder_init(protocol_decoder_t *decoder);
+
+/**
+ * Legge dal socket tutti i byte disponibili con una sola recv()
+ * 
+ * Compatta prima il buffer se necessario. Invalida i payload
+ * restituiti in precedenza da protocol_decoder_next().
+ * 
+ * @param decoder Puntatore al decoder
+ * @param sockfd File descriptor del socket
+ * @param flags Flag per recv() (es. MSG_DONTWAIT)
+ * @return Byte letti, 0 se connessione chiusa, -1 se errore (errno impostato)
+ */
+ssize_t protocol_decoder_fill(protocol_decoder_t *decoder, int sockfd, int flags);
+
+/**
+ * Accoda al decoder byte già ricevuti (es. da un buffer di io_uring)
+ * 
+ * Copia al più lo spazio libero: il chiamante deve estrarre i messaggi
+ * completi e riprovare con i byte restanti. Invalida i payload
+ * restituiti in precedenza da protocol_decoder_next().
+ * 
+ * @param decoder Puntatore al decoder
+ * @param data Byte ricevuti
+ * @param length Numero di byte
+ * @return Numero di byte copiati
+ */
+size_t protocol_decoder_feed(protocol_decoder_t *decoder, const void *data, size_t length);
+
+/**
+ * Estrae il prossimo messaggio completo dal decoder
+ * 
+ * L'header viene copiato e convertito in host byte order; il payload
+ * non viene copiato e resta valido fino alla prossima fill/feed.
+ * 
+ * @param decoder Puntatore al decoder
+ * @param header Header del messaggio estratto
+ * @param payload Puntatore al payload nel buffer (NULL se assente)
+ * @return 1 se estratto un messaggio, 0 se servono altri byte,
+ *         -1 se l'header dichiara un payload oltre MAX_MESSAGE_SIZE
+ */
+int protocol_decoder_next(protocol_decoder_t *decoder, protocol_header_t *header,
+                          const void **payload);
+
 // ============================================================================
 // FUNZIONI DI VALIDAZIONE
 // ============================================================================
@@ -2,51 +2,59 @@
 #include <string.h>
 #include <stdio.h>
 
+// Posizione dei campi nella parola di una partita compatta (vedi game_logic.h)
+#define BOARD_MASK 0x3FFFFu
+#define MOVES_SHIFT 18
+#define STATUS_SHIFT 22
+#define TURN_SHIFT 24
+#define WINNER_SHIFT 25
+
+// Sostituisce il campo di 'bits' bit in posizione 'shift'
+#define SET_FIELD(word, shift, bits, value) \
+    ((word) = ((word) & ~(((1u << (bits)) - 1) << (shift))) | ((uint32_t)(value) << (shift)))
+
+// Combinazioni vincenti (righe, colonne, diagonali) come maschere dei bit X
+// del tabellone compatto: le stesse spostate di un bit sono quelle di O
+#define LINE(a, b, c) ((1u << (2 * (a))) | (1u << (2 * (b))) | (1u << (2 * (c))))
+static const uint32_t winning_lines[8] = {
+    LINE(0, 1, 2), LINE(3, 4, 5), LINE(6, 7, 8),  // Righe
+    LINE(0, 3, 6), LINE(1, 4, 7), LINE(2, 5, 8),  // Colonne
+    LINE(0, 4, 8), LINE(2, 4, 6)                  // Diagonali
+};
+
 // ============================================================================
 // FUNZIONI DI INIZIALIZZAZIONE
 // ============================================================================
 
-void game_init(game_state_t *game, const char *game_id, const char *creator) {
-    if (!game || !game_id || !creator) return;
-    
-    // Inizializza i campi base
-    strncpy(game->game_id, game_id, MAX_GAME_ID_LEN - 1);
-    game->game_id[MAX_GAME_ID_LEN - 1] = '\0';
+void game_init(game_packed_t *game, uint32_t creator) {
+    if (!game || creator == 0) return;
     
-    strncpy(game->players[0], creator, MAX_PLAYER_NAME - 1);
-    game->players[0][MAX_PLAYER_NAME - 1] = '\0';
-    game->players[1][0] = '\0';  // Secondo giocatore vuoto
-    
-    // Inizializza il tabellone (tutte le posizioni vuote)
-    for (int i = 0; i < 9; i++) {
-        game->board[i] = EMPTY_CELL;
-    }
+    game->players[0] = creator;
+    game->players[1] = 0;  // Secondo giocatore vuoto
     
-    game->current_player = 0;   // Il creatore inizia sempre
-    game->status = GAME_WAITING;
-    game->move_count = 0;
-    game->winner = -1;          // Nessun vincitore
+    // Tabellone vuoto, nessuna mossa, nessun vincitore e turno al creatore
+    game->word = 0;
+    SET_FIELD(game->word, STATUS_SHIFT, 2, GAME_WAITING);
 }
 
-int game_add_player(game_state_t *game, const char *player_name) {
-    if (!game || !player_name) return 0;
+int game_add_player(game_packed_t *game, uint32_t player) {
+    if (!game || player == 0) return 0;
     
     // Controlla se c'è già un secondo giocatore
-    if (game->players[1][0] != '\0') {
+    if (game->players[1] != 0) {
         return 0;  // Partita già piena
     }
     
-    // Controlla che non sia lo stesso nome del creatore
-    if (strcmp(game->players[0], player_name) == 0) {
-        return 0;  // Stesso nome del creatore
+    // Controlla che non sia lo stesso giocatore del creatore
+    if (game->players[0] == player) {
+        return 0;
     }
     
     // Aggiunge il secondo giocatore
-    strncpy(game->players[1], player_name, MAX_PLAYER_NAME - 1);
-    game->players[1][MAX_PLAYER_NAME - 1] = '\0';
+    game->players[1] = player;
     
     // Cambia stato a "in corso"
-    game->status = GAME_IN_PROGRESS;
+    SET_FIELD(game->word, STATUS_SHIFT, 2, GAME_IN_PROGRESS);
     
     return 1;  // Successo
 }
@@ -55,40 +63,41 @@ int game_add_player(game_state_t *game, const char *player_name) {
 // FUNZIONI DI MOVIMENTO
 // ============================================================================
 
-int game_make_move(game_state_t *game, int player_idx, int position) {
+int game_make_move(game_packed_t *game, int player_idx, int position) {
     if (!game) return 0;
     
     // Validazioni di base
     if (player_idx < 0 || player_idx > 1) return 0;
     if (position < 1 || position > 9) return 0;
-    if (game->status != GAME_IN_PROGRESS) return 0;
-    if (player_idx != game->current_player) return 0;  // Non è il suo turno
+    if (GAME_STATUS(game) != GAME_IN_PROGRESS) return 0;
+    if (player_idx != GAME_CURRENT_PLAYER(game)) return 0;  // Non è il suo turno
     
     // Converte posizione 1-9 in indice 0-8
     int board_idx = position - 1;
     
     // Controlla se la cella è libera
-    if (game->board[board_idx] != EMPTY_CELL) {
+    if (GAME_CELL(game, board_idx) != CELL_EMPTY) {
         return 0;  // Cella già occupata
     }
     
     // Effettua la mossa
-    char symbol = game_get_player_symbol(game, player_idx);
-    game->board[board_idx] = symbol;
-    game->move_count++;
+    uint32_t cell = (player_idx == 0) ? CELL_X : CELL_O;
+    game->word |= cell << (2 * board_idx);
+    int move_count = GAME_MOVE_COUNT(game) + 1;
+    SET_FIELD(game->word, MOVES_SHIFT, 4, move_count);
     
     // Controlla se c'è un vincitore
     int winner = game_check_winner(game);
     if (winner != -1) {
-        game->winner = winner;
-        game->status = GAME_FINISHED;
-    } else if (game->move_count == 9) {
+        SET_FIELD(game->word, WINNER_SHIFT, 2, winner + 1);
+        SET_FIELD(game->word, STATUS_SHIFT, 2, GAME_FINISHED);
+    } else if (move_count == 9) {
         // Pareggio - tabellone pieno
-        game->winner = 2;  // Indica pareggio
-        game->status = GAME_FINISHED;
+        SET_FIELD(game->word, WINNER_SHIFT, 2, 3);  // Indica pareggio (vincitore 2)
+        SET_FIELD(game->word, STATUS_SHIFT, 2, GAME_FINISHED);
     } else {
         // Passa il turno all'altro giocatore
-        game->current_player = 1 - game->current_player;
+        game->word ^= 1u << TURN_SHIFT;
     }
     
     return 1;  // Mossa valida effettuata
@@ -98,60 +107,38 @@ int game_make_move(game_state_t *game, int player_idx, int position) {
 // FUNZIONI DI STATO
 // ============================================================================
 
-int game_check_winner(const game_state_t *game) {
+int game_check_winner(const game_packed_t *game) {
     if (!game) return -1;
     
-    char board[9];
-    memcpy(board, game->board, 9);
+    uint32_t board = game->word & BOARD_MASK;
     
-    // Combinazioni vincenti (righe, colonne, diagonali)
-    int winning_combinations[8][3] = {
-        {0, 1, 2}, {3, 4, 5}, {6, 7, 8},  // Righe
-        {0, 3, 6}, {1, 4, 7}, {2, 5, 8},  // Colonne
-        {0, 4, 8}, {2, 4, 6}              // Diagonali
-    };
-    
-    // Controlla ogni combinazione vincente
+    // Una linea è vinta se ha i tre bit del simbolo
     for (int i = 0; i < 8; i++) {
-        int pos1 = winning_combinations[i][0];
-        int pos2 = winning_combinations[i][1];
-        int pos3 = winning_combinations[i][2];
-        
-        if (board[pos1] != EMPTY_CELL &&
-            board[pos1] == board[pos2] &&
-            board[pos2] == board[pos3]) {
-            
-            // Trova quale giocatore ha vinto
-            char winning_symbol = board[pos1];
-            for (int player = 0; player < 2; player++) {
-                if (game_get_player_symbol(game, player) == winning_symbol) {
-                    return player;
-                }
-            }
-        }
+        if ((board & winning_lines[i]) == winning_lines[i]) return 0;
+        if ((board & (winning_lines[i] << 1)) == (winning_lines[i] << 1)) return 1;
     }
     
     return -1;  // Nessun vincitore
 }
 
-int game_is_finished(const game_state_t *game) {
+int game_is_finished(const game_packed_t *game) {
     if (!game) return 0;
-    return (game->status == GAME_FINISHED);
+    return (GAME_STATUS(game) == GAME_FINISHED);
 }
 
-int game_is_player_turn(const game_state_t *game, const char *player_name) {
-    if (!game || !player_name) return 0;
-    if (game->status != GAME_IN_PROGRESS) return 0;
+int game_is_player_turn(const game_packed_t *game, uint32_t player) {
+    if (!game || player == 0) return 0;
+    if (GAME_STATUS(game) != GAME_IN_PROGRESS) return 0;
     
-    return (strcmp(game->players[game->current_player], player_name) == 0);
+    return (game->players[GAME_CURRENT_PLAYER(game)] == player);
 }
 
 // ============================================================================
 // FUNZIONI DI UTILITÀ
 // ============================================================================
 
-char game_get_player_symbol(const game_state_t *game, int player_idx) {
-    if (!game || player_idx < 0 || player_idx > 1) return '\0';
+char game_get_player_symbol(int player_idx) {
+    if (player_idx < 0 || player_idx > 1) return '\0';
     
     // Il giocatore 0 (creatore) è sempre 'X', il giocatore 1 è sempre 'O'
     return (player_idx == 0) ? PLAYER_X : PLAYER_O;
@@ -212,8 +199,11 @@ void game_print_board(const game_state_t *game) {
     printf("\n");
 }
 
-void game_get_board_string(const game_state_t *game, char board_str[9]) {
+void game_get_board_string(const game_packed_t *game, char board_str[9]) {
     if (!game || !board_str) return;
     
-    memcpy(board_str, game->board, 9);
+    for (int i = 0; i < 9; i++) {
+        uint32_t cell = GAME_CELL(game, i);
+        board_str[i] = (cell == CELL_X) ? PLAYER_X : (cell == CELL_O) ? PLAYER_O : EMPTY_CELL;
+    }
 }
@@ -1,6 +1,8 @@
 #include "protocol.h"
 #include <arpa/inet.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <errno.h>
 #include <unistd.h>
 #include <string.h>
 #include <stdio.h>
@@ -37,29 +39,92 @@ void protocol_header_to_host(protocol_header_t *header) {
 // FUNZIONI DI INVIO/RICEZIONE
 // ============================================================================
 
-ssize_t protocol_send(int sockfd, uint8_t msg_type, const void *payload, 
-                     size_t payload_size, uint32_t seq_id) {
-    protocol_header_t header;
+/**
+ * Invia tutti i byte descritti da iov, riprendendo dopo invii parziali
+ * 
+ * L'array iov viene modificato per avanzare oltre i byte già inviati.
+ * MSG_NOSIGNAL evita SIGPIPE se il peer ha chiuso la connessione.
+ */
+static ssize_t send_all_iov(int sockfd, struct iovec *iov, int iovcnt) {
     ssize_t total_sent = 0;
-    ssize_t bytes_sent;
     
-    // Initialize header
-    protocol_init_header(&header, msg_type, (uint16_t)payload_size, seq_id);
-    
-    // Send header
-    bytes_sent = send(sockfd, &header, sizeof(protocol_header_t), 0);
-    if (bytes_sent <= 0) {
-        return -1;
+    while (iovcnt > 0) {
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iovcnt;
+        
+        ssize_t bytes_sent = sendmsg(sockfd, &msg, MSG_NOSIGNAL);
+        if (bytes_sent < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (bytes_sent == 0) {
+            return -1;
+        }
+        total_sent += bytes_sent;
+        
+        // Salta i buffer completamente inviati e avanza in quello parziale
+        size_t remaining = (size_t)bytes_sent;
+        while (iovcnt > 0 && remaining >= iov->iov_len) {
+            remaining -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char*)iov->iov_base + remaining;
+            iov->iov_len -= remaining;
+        }
     }
-    total_sent += bytes_sent;
     
-    // Send payload if present
-    if (payload && payload_size > 0) {
-        bytes_sent = send(sockfd, payload, payload_size, 0);
-        if (bytes_sent <= 0) {
+    return total_sent;
+}
+
+ssize_t protocol_send(int sockfd, uint8_t msg_type, const void *payload, 
+                     size_t payload_size, uint32_t seq_id) {
+    protocol_frame_t frame = { msg_type, payload, payload_size, seq_id };
+    return protocol_send_batch(sockfd, &frame, 1);
+}
+
+ssize_t protocol_send_batch(int sockfd, const protocol_frame_t *frames, size_t count) {
+    if (!frames) return -1;
+    
+    protocol_header_t headers[PROTOCOL_MAX_BATCH];
+    struct iovec iov[PROTOCOL_MAX_BATCH * 2];
+    ssize_t total_sent = 0;
+    
+    // Oltre PROTOCOL_MAX_BATCH messaggi si procede a blocchi
+    while (count > 0) {
+        size_t batch = count < PROTOCOL_MAX_BATCH ? count : PROTOCOL_MAX_BATCH;
+        int iovcnt = 0;
+        
+        for (size_t i = 0; i < batch; i++) {
+            size_t payload_size = frames[i].payload ? frames[i].payload_size : 0;
+            
+            // Initialize header
+            protocol_init_header(&headers[i], frames[i].msg_type, 
+                                (uint16_t)payload_size, frames[i].seq_id);
+            iov[iovcnt].iov_base = &headers[i];
+            iov[iovcnt].iov_len = sizeof(protocol_header_t);
+            iovcnt++;
+            
+            // Payload if present
+            if (payload_size > 0) {
+                iov[iovcnt].iov_base = (void*)frames[i].payload;
+                iov[iovcnt].iov_len = payload_size;
+                iovcnt++;
+            }
+        }
+        
+        // Header e payload di tutti i messaggi con un'unica sendmsg
+        ssize_t bytes_sent = send_all_iov(sockfd, iov, iovcnt);
+        if (bytes_sent < 0) {
             return -1;
         }
         total_sent += bytes_sent;
+        
+        frames += batch;
+        count -= batch;
     }
     
     return total_sent;
@@ -112,6 +177,87 @@ ssize_t protocol_recv_payload(int sockfd, void *buffer, size_t length) {
     return total_received;
 }
 
+// ============================================================================
+// DECODER DI MESSAGGI IN RICEZIONE
+// ============================================================================
+
+void protocol_decoder_init(protocol_decoder_t *decoder) {
+    if (!decoder) return;
+    
+    decoder->start = 0;
+    decoder->end = 0;
+}
+
+/**
+ * Sposta i byte non consumati all'inizio del buffer
+ */
+static void decoder_compact(protocol_decoder_t *decoder) {
+    if (decoder->start == 0) return;
+    
+    size_t pending = decoder->end - decoder->start;
+    if (pending > 0) {
+        memmove(decoder->buf, decoder->buf + decoder->start, pending);
+    }
+    decoder->start = 0;
+    decoder->end = pending;
+}
+
+ssize_t protocol_decoder_fill(protocol_decoder_t *decoder, int sockfd, int flags) {
+    if (!decoder) return -1;
+    
+    decoder_compact(decoder);
+    
+    ssize_t bytes_received = recv(sockfd, decoder->buf + decoder->end, 
+                                  sizeof(decoder->buf) - decoder->end, flags);
+    if (bytes_received > 0) {
+        decoder->end += bytes_received;
+    }
+    
+    return bytes_received;
+}
+
+size_t protocol_decoder_feed(protocol_decoder_t *decoder, const void *data, size_t length) {
+    if (!decoder || !data) return 0;
+    
+    decoder_compact(decoder);
+    
+    size_t space = sizeof(decoder->buf) - decoder->end;
+    size_t copied = length < space ? length : space;
+    memcpy(decoder->buf + decoder->end, data, copied);
+    decoder->end += copied;
+    
+    return copied;
+}
+
+int protocol_decoder_next(protocol_decoder_t *decoder, protocol_header_t *header,
+                          const void **payload) {
+    if (!decoder || !header || !payload) return -1;
+    
+    size_t available = decoder->end - decoder->start;
+    if (available < sizeof(protocol_header_t)) {
+        return 0;
+    }
+    
+    // Convert from network to host byte order
+    memcpy(header, decoder->buf + decoder->start, sizeof(protocol_header_t));
+    protocol_header_to_host(header);
+    
+    if (header->length > MAX_MESSAGE_SIZE) {
+        return -1;
+    }
+    
+    size_t frame_size = sizeof(protocol_header_t) + header->length;
+    if (available < frame_size) {
+        return 0; // Messaggio incompleto
+    }
+    
+    *payload = header->length > 0 ? 
+               decoder->buf + decoder->start + sizeof(protocol_header_t) : NULL;
+    decoder->start += frame_size;
+    
+    return 1;
+}
+
 // ============================================================================
 // FUNZIONI DI VALIDAZIONE
 // ============================================================================